@@ -1,13 +1,14 @@
 #include "Book.h"
+#include <utility>
 
 Book::Book(const std::string& isbn, const std::string& title, const std::string& author, const std::string& genre, int year, int copies)
     : isbn(isbn), title(title), author(author), genre(genre),
       publicationYear(year), totalCopies(copies), availableCopies(copies),
       status(Status::AVAILABLE) {}
 
-Book::Book(const std::string& isbn, const std::string& title, const std::string& author, const std::string& genre,
+Book::Book(std::string isbn, std::string title, std::string author, std::string genre,
            int publicationYear, int totalCopies, int availableCopies, Status status)
-    : isbn(isbn), title(title), author(author), genre(genre),
+    : isbn(std::move(isbn)), title(std::move(title)), author(std::move(author)), genre(std::move(genre)),
       publicationYear(publicationYear), totalCopies(totalCopies),
       availableCopies(availableCopies), status(status) 
 {
@@ -17,6 +18,10 @@ Book::Book(const std::string& isbn, const std::string& title, const std::string&
 }
 
 std::string Book::getStatusString() const {
+    return statusToString(status);
+}
+
+std::string Book::statusToString(Status status) {
     switch(status) {
         case Status::AVAILABLE: return "Доступна";
         case Status::BORROWED: return "Позичена";
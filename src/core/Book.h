@@ -19,13 +19,13 @@ public:
     // Constructors
     Book(const std::string& isbn, const std::string& title, const std::string& author,
          const std::string& genre, int publicationYear, int copies);
-    Book(const std::string& isbn, const std::string& title, const std::string& author,
-         const std::string& genre, int publicationYear, int totalCopies, int availableCopies, Status status);
+    Book(std::string isbn, std::string title, std::string author,
+         std::string genre, int publicationYear, int totalCopies, int availableCopies, Status status);
 
-    std::string getISBN() const { return isbn; }
-    std::string getTitle() const { return title; }
-    std::string getAuthor() const { return author; }
-    std::string getGenre() const { return genre; }
+    const std::string& getISBN() const { return isbn; }
+    const std::string& getTitle() const { return title; }
+    const std::string& getAuthor() const { return author; }
+    const std::string& getGenre() const { return genre; }
     int getPublicationYear() const { return publicationYear; }
     int getTotalCopies() const { return totalCopies; }
     int getAvailableCopies() const { return availableCopies; }
@@ -36,6 +36,7 @@ public:
     void setStatus(Status s) { status = s; }
 
     std::string getStatusString() const;
+    static std::string statusToString(Status status);
     bool borrowBook();
     bool returnBook();   
     bool reserveBook();
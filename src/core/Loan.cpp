@@ -1,6 +1,7 @@
 #include "Loan.h"
 #include <chrono>
 #include <cassert>
+#include <utility>
 
 // Constructors
 Loan::Loan(int id, const std::string& isbn, int memberId, int days)
@@ -9,13 +10,13 @@ Loan::Loan(int id, const std::string& isbn, int memberId, int days)
       dueDate(std::chrono::system_clock::now() + std::chrono::hours(24 * days)),
       returnDate(), isReturned(false), fineAmount(0.0) {}
 
-Loan::Loan(int id, const std::string& isbn, int memberId,
+Loan::Loan(int id, std::string isbn, int memberId,
            std::chrono::system_clock::time_point loanDate,
            std::chrono::system_clock::time_point dueDate,
            std::chrono::system_clock::time_point returnDate,
            bool isReturned,
            double fineAmount)
-    : id(id), bookISBN(isbn), memberId(memberId),
+    : id(id), bookISBN(std::move(isbn)), memberId(memberId),
       loanDate(loanDate), dueDate(dueDate),
       returnDate(returnDate), isReturned(isReturned),
       fineAmount(fineAmount) {}
@@ -31,7 +32,7 @@ bool Loan::isOverdue() const {
 }
 
 double Loan::calculateFine() const {
-    // Calculate fine as 5.0 per overdue day (same as prior logic)
+    // Calculate fine as FINE_PER_DAY per overdue day (same as prior logic)
     std::chrono::system_clock::time_point comparePoint;
     if (isReturned) {
         comparePoint = returnDate;
@@ -43,7 +44,7 @@ double Loan::calculateFine() const {
 
     auto overdueHours = std::chrono::duration_cast<std::chrono::hours>(comparePoint - dueDate).count();
     int overdueDays = static_cast<int>((overdueHours + 23) / 24); // round up partial days
-    double fine = overdueDays * 5.0; // 5 units per day
+    double fine = overdueDays * FINE_PER_DAY;
     return fine;
 }
 
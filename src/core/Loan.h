@@ -14,8 +14,11 @@ private:
     double fineAmount;
 
 public:
+    // Charged per started overdue day; DatabaseManager::returnBatch uses the same rule in SQL
+    static constexpr double FINE_PER_DAY = 5.0;
+
     Loan(int id, const std::string& isbn, int memberId, int days);
-    Loan(int id, const std::string& isbn, int memberId,
+    Loan(int id, std::string isbn, int memberId,
          std::chrono::system_clock::time_point loanDate,
          std::chrono::system_clock::time_point dueDate,
          std::chrono::system_clock::time_point returnDate,
@@ -23,7 +26,7 @@ public:
          double fineAmount);
 
     int getId() const { return id; }
-    std::string getBookISBN() const { return bookISBN; }
+    const std::string& getBookISBN() const { return bookISBN; }
     int getMemberId() const { return memberId; }
     auto getLoanDate() const { return loanDate; }
     auto getDueDate() const { return dueDate; }
@@ -1,4 +1,5 @@
 #include "Member.h"
+#include <utility>
 
 Member::Member(int id, const std::string& name, const std::string& email, const std::string& phone, Type memberType)
     : id(id), name(name), email(email), phone(phone), type(memberType) {
@@ -19,10 +20,14 @@ Member::Member(int id, const std::string& name, const std::string& email, const
 
     } // default
 
-Member::Member(int id, const std::string& name, const std::string& email, const std::string& phone, Type memberType, int maxAllowed)
-    : id(id), name(name), email(email), phone(phone), type(memberType), maxBooksAllowed(maxAllowed) {}
+Member::Member(int id, std::string name, std::string email, std::string phone, Type memberType, int maxAllowed)
+    : id(id), name(std::move(name)), email(std::move(email)), phone(std::move(phone)), type(memberType), maxBooksAllowed(maxAllowed) {}
 
 std::string Member::getTypeString() const {
+    return typeToString(type);
+}
+
+std::string Member::typeToString(Type type) {
     switch (type) {
         case Type::STUDENT: return "Студент";
         case Type::FACULTY: return "Викладач";
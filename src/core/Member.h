@@ -15,14 +15,15 @@ private:
 
 public:
     Member(int id, const std::string& name, const std::string& email, const std::string& phone, Type memberType);
-    Member(int id, const std::string& name, const std::string& email, const std::string& phone, Type memberType, int maxAllowed);
+    Member(int id, std::string name, std::string email, std::string phone, Type memberType, int maxAllowed);
 
     int getId() const { return id; }
-    std::string getName() const { return name; }
-    std::string getEmail() const { return email; }
-    std::string getPhone() const { return phone; }
+    const std::string& getName() const { return name; }
+    const std::string& getEmail() const { return email; }
+    const std::string& getPhone() const { return phone; }
     Type getType() const { return type; }
     std::string getTypeString() const;
+    static std::string typeToString(Type type);
     int getMaxBooksAllowed() const { return maxBooksAllowed; }
     
     void setPhone(const std::string& p) { phone = p; }
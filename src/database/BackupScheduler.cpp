@@ -0,0 +1,149 @@
+#include "BackupScheduler.h"
+#include <ctime>
+#include <cstring>
+#include <vector>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+
+static const char* const BACKUP_PREFIX = "library-";
+static const char* const BACKUP_SUFFIX = ".db";
+static const char* const STAMP_FORMAT = "%Y%m%d-%H%M%S";
+
+static std::tm localTime(std::time_t t) {
+    std::tm tm{};
+#ifdef _WIN32
+    localtime_s(&tm, &t);
+#else
+    localtime_r(&t, &tm);
+#endif
+    return tm;
+}
+
+// Names of finished backups in the directory, oldest first (the timestamp sorts as text)
+static std::vector<std::string> listBackups(const std::string& directory) {
+    std::vector<std::string> names;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        std::string name = entry.path().filename().string();
+        if (name.rfind(BACKUP_PREFIX, 0) == 0 && name.size() > std::strlen(BACKUP_SUFFIX) &&
+            name.compare(name.size() - std::strlen(BACKUP_SUFFIX), std::string::npos, BACKUP_SUFFIX) == 0) {
+            names.push_back(name);
+        }
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+BackupScheduler::BackupScheduler(DatabaseManager& db, const BackupSchedule& schedule) : db(db), schedule(schedule) {
+    std::error_code error;
+    std::filesystem::create_directories(schedule.directory, error);
+    auto newest = newestBackupTime();
+    auto now = std::chrono::system_clock::now();
+    // Without a recent backup, take one shortly after start rather than competing with it
+    status.nextDue = newest + schedule.interval > now ? newest + schedule.interval : now + std::chrono::minutes(1);
+    thread = std::thread(&BackupScheduler::run, this);
+}
+
+BackupScheduler::~BackupScheduler() {
+    stop();
+}
+
+void BackupScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) return;
+        stopping = true;
+    }
+    wake.notify_one();
+    if (thread.joinable()) thread.join();
+}
+
+void BackupScheduler::requestBackup() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        requested = true;
+    }
+    wake.notify_one();
+}
+
+BackupStatus BackupScheduler::getStatus() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return status;
+}
+
+void BackupScheduler::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait_until(lock, status.nextDue, [this] {
+            return stopping || requested || std::chrono::system_clock::now() >= status.nextDue;
+        });
+        if (stopping) break;
+
+        requested = false;
+        status.running = true;
+        status.progress = BackupProgress();
+        lock.unlock();
+        runBackup();
+        lock.lock();
+        status.running = false;
+        status.nextDue = std::chrono::system_clock::now() + schedule.interval;
+    }
+}
+
+void BackupScheduler::runBackup() {
+    std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    std::tm tm = localTime(now);
+    std::ostringstream name;
+    name << BACKUP_PREFIX << std::put_time(&tm, STAMP_FORMAT) << BACKUP_SUFFIX;
+    std::string target = (std::filesystem::path(schedule.directory) / name.str()).string();
+
+    BackupProgress last;
+    bool ok = db.backupTo(target, schedule.pagesPerStep, schedule.pause, [this, &last](const BackupProgress& progress) {
+        last = progress;
+        std::lock_guard<std::mutex> lock(mutex);
+        status.progress = progress;
+        return !stopping;
+    });
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (ok) {
+            status.lastFile = target;
+            status.lastError.clear();
+            status.lastFinished = std::chrono::system_clock::now();
+        } else if (!stopping) {
+            status.lastError = "Не вдалося створити резервну копію " + target;
+        }
+    }
+    if (!ok) return;
+
+    std::cout << "Backup written to " << target << ": " << std::fixed << std::setprecision(1)
+              << last.bytesCopied / (1024.0 * 1024.0) << " MiB in " << last.seconds << " s ("
+              << last.mibPerSecond() << " MiB/s)" << std::defaultfloat << std::endl;
+    rotate();
+}
+
+void BackupScheduler::rotate() {
+    std::vector<std::string> names = listBackups(schedule.directory);
+    for (size_t i = 0; i + schedule.keep < names.size(); ++i) {
+        std::error_code error;
+        std::filesystem::remove(std::filesystem::path(schedule.directory) / names[i], error);
+        if (error) std::cerr << "Could not delete old backup " << names[i] << ": " << error.message() << std::endl;
+    }
+}
+
+std::chrono::system_clock::time_point BackupScheduler::newestBackupTime() const {
+    std::vector<std::string> names = listBackups(schedule.directory);
+    if (names.empty()) return {};
+
+    std::string stamp = names.back().substr(std::strlen(BACKUP_PREFIX));
+    std::tm tm{};
+    std::istringstream in(stamp);
+    in >> std::get_time(&tm, STAMP_FORMAT);
+    if (in.fail()) return {};
+    tm.tm_isdst = -1;
+    return std::chrono::system_clock::from_time_t(std::mktime(&tm));
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <mutex>
+#include <thread>
+#include <string>
+#include <chrono>
+#include <condition_variable>
+#include "DatabaseManager.h"
+
+struct BackupSchedule {
+    std::string directory = "data/backups";
+    std::chrono::minutes interval{24 * 60};
+    int keep = 7;                                 // newest backups kept; older ones are deleted
+    int pagesPerStep = 128;                       // 512 KiB at the default page size
+    std::chrono::milliseconds pause{5};           // between steps, so desk writes get the connection
+};
+
+struct BackupStatus {
+    bool running = false;
+    BackupProgress progress;                      // of the running backup, or of the last one
+    std::string lastFile;                         // last completed backup
+    std::string lastError;
+    std::chrono::system_clock::time_point lastFinished{};
+    std::chrono::system_clock::time_point nextDue{};
+};
+
+// Takes timestamped online backups (library-YYYYMMDD-HHMMSS.db) on its own thread: one when the
+// newest backup is older than the interval, and one whenever requestBackup() is called. The copy
+// runs a few pages per step, so a multi-GB file only ever holds the database for short moments.
+class BackupScheduler {
+private:
+    DatabaseManager& db;
+    BackupSchedule schedule;
+    std::thread thread;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    bool requested = false;
+    BackupStatus status;
+
+    void run();
+    void runBackup();
+    void rotate();
+    std::chrono::system_clock::time_point newestBackupTime() const;
+
+public:
+    explicit BackupScheduler(DatabaseManager& db, const BackupSchedule& schedule = BackupSchedule());
+    ~BackupScheduler();
+    BackupScheduler(const BackupScheduler&) = delete;
+    BackupScheduler& operator=(const BackupScheduler&) = delete;
+
+    void requestBackup();
+    BackupStatus getStatus() const;
+
+    // Cancels a backup in progress and joins the thread.
+    void stop();
+};
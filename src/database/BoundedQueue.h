@@ -0,0 +1,51 @@
+#pragma once
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <condition_variable>
+
+// Blocking multi-producer/multi-consumer queue with a fixed capacity. push() waits while the queue is
+// full, pop() waits while it is empty; after close() pushes are dropped and pop() drains what is left.
+template <typename T>
+class BoundedQueue {
+private:
+    std::deque<T> items;
+    std::size_t capacity;
+    bool closed = false;
+    std::mutex mutex;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+
+public:
+    explicit BoundedQueue(std::size_t capacity) : capacity(capacity ? capacity : 1) {}
+
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [&] { return closed || items.size() < capacity; });
+        if (closed) return false;
+        items.push_back(std::move(item));
+        lock.unlock();
+        notEmpty.notify_one();
+        return true;
+    }
+
+    std::optional<T> pop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [&] { return closed || !items.empty(); });
+        if (items.empty()) return std::nullopt;
+        T item = std::move(items.front());
+        items.pop_front();
+        lock.unlock();
+        notFull.notify_one();
+        return item;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        notFull.notify_all();
+        notEmpty.notify_all();
+    }
+};
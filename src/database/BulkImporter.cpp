@@ -0,0 +1,501 @@
+#include "BulkImporter.h"
+#include "BoundedQueue.h"
+#include "RowMapper.h"
+#include "../core/Book.h"
+#include "../core/Member.h"
+#include "../core/Loan.h"
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <charconv>
+#include <optional>
+#include <algorithm>
+
+namespace {
+
+const std::size_t MAX_SAMPLE_ERRORS = 10;
+
+struct RawRecord {
+    std::size_t line;
+    std::string text;
+};
+using RawChunk = std::vector<RawRecord>;
+
+struct BookRow {
+    std::size_t line;
+    std::string isbn, title, author, genre;
+    int publicationYear, totalCopies, availableCopies;
+};
+
+struct MemberRow {
+    std::size_t line;
+    std::string name, email, phone;
+    int type, maxBooksAllowed;
+};
+
+struct LoanRow {
+    std::size_t line;
+    std::string bookIsbn;
+    int memberId;
+    std::int64_t loanDate, dueDate;
+    std::optional<std::int64_t> returnDate;
+    double fineAmount;
+};
+
+template <typename Row>
+struct ParsedChunk {
+    std::vector<Row> rows;
+    std::size_t rejected = 0;
+    std::vector<std::string> errors;
+};
+
+// Splits one CSV record into fields. Handles quoted fields, doubled quotes and embedded newlines.
+std::vector<std::string> splitCsv(const std::string& text) {
+    std::vector<std::string> fields(1);
+    bool quoted = false;
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        char c = text[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < text.size() && text[i + 1] == '"') { fields.back() += '"'; ++i; }
+            else if (c == '"') quoted = false;
+            else fields.back() += c;
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.emplace_back();
+        } else if (c != '\r') {
+            fields.back() += c;
+        }
+    }
+    for (auto& field : fields) {
+        auto first = field.find_first_not_of(" \t");
+        auto last = field.find_last_not_of(" \t");
+        field = first == std::string::npos ? std::string() : field.substr(first, last - first + 1);
+    }
+    return fields;
+}
+
+template <typename T>
+bool parseNumber(const std::string& text, T& out) {
+    auto result = std::from_chars(text.data(), text.data() + text.size(), out);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+bool parseDouble(const std::string& text, double& out) {
+    try {
+        std::size_t used = 0;
+        out = std::stod(text, &used);
+        return used == text.size();
+    } catch (...) {
+        return false;
+    }
+}
+
+// Unix seconds, or a YYYY-MM-DD date taken as midnight UTC.
+bool parseDate(const std::string& text, std::int64_t& out) {
+    if (parseNumber(text, out)) return true;
+    int y = 0;
+    unsigned m = 0, d = 0;
+    if (text.size() != 10 || text[4] != '-' || text[7] != '-' ||
+        !parseNumber(text.substr(0, 4), y) || !parseNumber(text.substr(5, 2), m) || !parseNumber(text.substr(8, 2), d)) {
+        return false;
+    }
+    std::chrono::year_month_day date{std::chrono::year{y}, std::chrono::month{m}, std::chrono::day{d}};
+    if (!date.ok()) return false;
+    out = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::sys_days{date}.time_since_epoch()).count();
+    return true;
+}
+
+std::optional<BookRow> parseBook(const RawRecord& record, std::string& error) {
+    auto f = splitCsv(record.text);
+    if (f.size() < 6) { error = "expected at least 6 columns"; return std::nullopt; }
+    BookRow row{record.line, std::move(f[0]), std::move(f[1]), std::move(f[2]), std::move(f[3]), 0, 0, 0};
+    if (row.isbn.empty() || row.title.empty() || row.author.empty()) { error = "isbn, title and author are required"; return std::nullopt; }
+    if (!f[4].empty() && !parseNumber(f[4], row.publicationYear)) { error = "bad publication_year"; return std::nullopt; }
+    if (!parseNumber(f[5], row.totalCopies) || row.totalCopies < 0) { error = "bad total_copies"; return std::nullopt; }
+    row.availableCopies = row.totalCopies;
+    if (f.size() > 6 && !f[6].empty()) {
+        if (!parseNumber(f[6], row.availableCopies)) { error = "bad available_copies"; return std::nullopt; }
+        row.availableCopies = std::clamp(row.availableCopies, 0, row.totalCopies);
+    }
+    return row;
+}
+
+std::optional<MemberRow> parseMember(const RawRecord& record, std::string& error) {
+    auto f = splitCsv(record.text);
+    if (f.size() < 4) { error = "expected at least 4 columns"; return std::nullopt; }
+    MemberRow row{record.line, std::move(f[0]), std::move(f[1]), std::move(f[2]), -1, 0};
+    if (row.name.empty()) { error = "name is required"; return std::nullopt; }
+
+    std::string type = f[3];
+    std::transform(type.begin(), type.end(), type.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (type == "0" || type == "student") row.type = static_cast<int>(Member::Type::STUDENT);
+    else if (type == "1" || type == "faculty") row.type = static_cast<int>(Member::Type::FACULTY);
+    else if (type == "2" || type == "external") row.type = static_cast<int>(Member::Type::EXTERNAL);
+    else { error = "unknown member_type"; return std::nullopt; }
+
+    if (f.size() > 4 && !f[4].empty()) {
+        if (!parseNumber(f[4], row.maxBooksAllowed) || row.maxBooksAllowed < 0) { error = "bad max_books_allowed"; return std::nullopt; }
+    } else {
+        row.maxBooksAllowed = Member(0, row.name, row.email, row.phone, static_cast<Member::Type>(row.type)).getMaxBooksAllowed();
+    }
+    return row;
+}
+
+std::optional<LoanRow> parseLoan(const RawRecord& record, std::string& error) {
+    auto f = splitCsv(record.text);
+    if (f.size() < 4) { error = "expected at least 4 columns"; return std::nullopt; }
+    LoanRow row{record.line, std::move(f[0]), 0, 0, 0, std::nullopt, 0.0};
+    if (row.bookIsbn.empty()) { error = "book_isbn is required"; return std::nullopt; }
+    if (!parseNumber(f[1], row.memberId)) { error = "bad member_id"; return std::nullopt; }
+    if (!parseDate(f[2], row.loanDate)) { error = "bad loan_date"; return std::nullopt; }
+    if (!parseDate(f[3], row.dueDate) || row.dueDate < row.loanDate) { error = "bad due_date"; return std::nullopt; }
+    if (f.size() > 4 && !f[4].empty()) {
+        std::int64_t returned = 0;
+        if (!parseDate(f[4], returned) || returned < row.loanDate) { error = "bad return_date"; return std::nullopt; }
+        row.returnDate = returned;
+    }
+    if (f.size() > 5 && !f[5].empty()) {
+        if (!parseDouble(f[5], row.fineAmount) || row.fineAmount < 0.0) { error = "bad fine_amount"; return std::nullopt; }
+    } else if (row.returnDate) {
+        using std::chrono::system_clock;
+        Loan loan(0, row.bookIsbn, row.memberId,
+                  system_clock::time_point(std::chrono::seconds(row.loanDate)),
+                  system_clock::time_point(std::chrono::seconds(row.dueDate)),
+                  system_clock::time_point(std::chrono::seconds(*row.returnDate)), true, 0.0);
+        row.fineAmount = loan.calculateFine();
+    }
+    return row;
+}
+
+void bindRow(sqlite3_stmt* stmt, const BookRow& row) {
+    bindParams(stmt, row.isbn, row.title, row.author, row.genre, row.publicationYear, row.totalCopies, row.availableCopies,
+               row.availableCopies > 0 ? Book::Status::AVAILABLE : Book::Status::BORROWED);
+}
+
+void bindRow(sqlite3_stmt* stmt, const MemberRow& row) {
+    // Empty emails are stored as NULL so they do not collide on the UNIQUE constraint
+    bindParams(stmt, row.name, row.email.empty() ? nullptr : row.email.c_str(), row.phone, row.type, row.maxBooksAllowed);
+}
+
+void bindRow(sqlite3_stmt* stmt, const LoanRow& row) {
+    bindParams(stmt, row.bookIsbn, row.memberId, row.loanDate, row.dueDate, row.returnDate, row.returnDate.has_value(),
+               row.fineAmount);
+}
+
+bool exec(sqlite3* db, const std::string& sql) {
+    char* err = nullptr;
+    if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &err) != SQLITE_OK) {
+        std::cerr << "SQLite exec failed (import): " << (err ? err : "unknown") << std::endl;
+        if (err) sqlite3_free(err);
+        return false;
+    }
+    return true;
+}
+
+void addError(ImportStats& stats, std::size_t line, const std::string& reason) {
+    if (stats.sampleErrors.size() < MAX_SAMPLE_ERRORS) {
+        stats.sampleErrors.push_back("line " + std::to_string(line) + ": " + reason);
+    }
+}
+
+// Reads raw records and hands them to the parser stage in chunks.
+void readRecords(std::ifstream& in, const ImportOptions& options, BoundedQueue<RawChunk>& out, std::atomic<std::size_t>& rowsRead) {
+    RawChunk chunk;
+    chunk.reserve(options.chunkRows);
+    std::string line;
+    std::size_t lineNumber = 0;
+    bool skipHeader = options.hasHeader;
+
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        RawRecord record{lineNumber, std::move(line)};
+        // A quoted field may span several physical lines
+        while (std::count(record.text.begin(), record.text.end(), '"') % 2 != 0 && std::getline(in, line)) {
+            ++lineNumber;
+            record.text += '\n';
+            record.text += line;
+        }
+        if (skipHeader) { skipHeader = false; continue; }
+        if (record.text.find_first_not_of(" \t\r") == std::string::npos) continue;
+
+        chunk.push_back(std::move(record));
+        rowsRead.fetch_add(1, std::memory_order_relaxed);
+        if (chunk.size() >= options.chunkRows) {
+            if (!out.push(std::move(chunk))) return;
+            chunk = RawChunk();
+            chunk.reserve(options.chunkRows);
+        }
+    }
+    if (!chunk.empty()) out.push(std::move(chunk));
+}
+
+template <typename Row, typename Parser>
+bool runPipeline(sqlite3* db, std::ifstream& in, const ImportOptions& options, const char* insertSql,
+                 Parser parse, ImportStats& stats) {
+    sqlite3_stmt* insert = nullptr;
+    if (sqlite3_prepare_v2(db, insertSql, -1, &insert, nullptr) != SQLITE_OK) {
+        std::cerr << "SQLite prepare failed (import): " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+
+    int parsers = options.parserThreads;
+    if (parsers <= 0) parsers = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 2);
+
+    BoundedQueue<RawChunk> rawQueue(options.queueChunks);
+    BoundedQueue<ParsedChunk<Row>> parsedQueue(options.queueChunks);
+    std::atomic<std::size_t> rowsRead{0};
+    std::atomic<int> parsersLeft{parsers};
+
+    std::thread reader([&] {
+        readRecords(in, options, rawQueue, rowsRead);
+        rawQueue.close();
+    });
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < parsers; ++i) {
+        workers.emplace_back([&] {
+            while (auto chunk = rawQueue.pop()) {
+                ParsedChunk<Row> parsed;
+                parsed.rows.reserve(chunk->size());
+                for (const auto& record : *chunk) {
+                    std::string error;
+                    if (auto row = parse(record, error)) {
+                        parsed.rows.push_back(std::move(*row));
+                    } else {
+                        ++parsed.rejected;
+                        if (parsed.errors.size() < MAX_SAMPLE_ERRORS) {
+                            parsed.errors.push_back("line " + std::to_string(record.line) + ": " + error);
+                        }
+                    }
+                }
+                if (!parsedQueue.push(std::move(parsed))) break;
+            }
+            if (parsersLeft.fetch_sub(1) == 1) parsedQueue.close();
+        });
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    bool ok = exec(db, "BEGIN;");
+    std::size_t rowsInTransaction = 0;
+
+    while (ok) {
+        auto parsed = parsedQueue.pop();
+        if (!parsed) break;
+
+        stats.rowsRejected += parsed->rejected;
+        for (const auto& error : parsed->errors) {
+            if (stats.sampleErrors.size() < MAX_SAMPLE_ERRORS) stats.sampleErrors.push_back(error);
+        }
+
+        for (const auto& row : parsed->rows) {
+            bindRow(insert, row);
+            if (sqlite3_step(insert) == SQLITE_DONE) {
+                ++stats.rowsImported;
+            } else {
+                // Constraint failures only undo this row; the batch transaction stays open
+                ++stats.rowsRejected;
+                addError(stats, row.line, sqlite3_errmsg(db));
+            }
+            sqlite3_reset(insert);
+        }
+
+        rowsInTransaction += parsed->rows.size();
+        if (rowsInTransaction >= options.batchRows) {
+            ok = exec(db, "COMMIT;") && exec(db, "BEGIN;");
+            rowsInTransaction = 0;
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+            std::cout << "  " << stats.rowsImported << " rows imported ("
+                      << static_cast<long long>(elapsed > 0.0 ? stats.rowsImported / elapsed : 0.0) << " rows/s)" << std::endl;
+        }
+    }
+
+    if (ok) {
+        ok = exec(db, "COMMIT;");
+    } else {
+        exec(db, "ROLLBACK;");
+    }
+
+    // Unblock the producers if the writer stopped early
+    rawQueue.close();
+    parsedQueue.close();
+    reader.join();
+    for (auto& worker : workers) worker.join();
+    sqlite3_finalize(insert);
+
+    stats.rowsRead = rowsRead.load();
+    return ok;
+}
+
+struct SchemaDefinition {
+    std::string name;
+    std::string sql;
+};
+
+// Schema objects of one type attached to a table, optionally only those whose name starts with a prefix.
+std::vector<SchemaDefinition> schemaObjects(sqlite3* db, const char* type, const char* table, const std::string& prefix = "") {
+    std::vector<SchemaDefinition> objects;
+    sqlite3_stmt* stmt = nullptr;
+    const char* sql = "SELECT name, sql FROM sqlite_master WHERE type = ? AND tbl_name = ? AND substr(name, 1, length(?3)) = ?3 AND sql IS NOT NULL";
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) return objects;
+    bindParams(stmt, type, table, prefix);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        auto [name, definition] = readRow<std::string, std::string>(stmt);
+        objects.push_back({std::move(name), std::move(definition)});
+    }
+    sqlite3_finalize(stmt);
+    return objects;
+}
+
+// Drops an index or trigger and keeps its definition in import_dropped. Done inside the caller's
+// transaction, so a crash mid-import still leaves the definition for --reconcile to restore.
+bool dropRecorded(sqlite3* db, const char* type, const SchemaDefinition& object) {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO import_dropped (name, sql) VALUES (?, ?)", -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "SQLite prepare failed (import): " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+    bindParams(stmt, object.name, object.sql);
+    bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+    sqlite3_finalize(stmt);
+    return ok && exec(db, std::string("DROP ") + type + " IF EXISTS \"" + object.name + "\";");
+}
+
+// Re-creates a dropped object and clears its record.
+bool restoreRecorded(sqlite3* db, const SchemaDefinition& object) {
+    if (!exec(db, object.sql + ";")) return false;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "DELETE FROM import_dropped WHERE name = ?", -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "SQLite prepare failed (import): " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+    bindParams(stmt, object.name);
+    bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+    sqlite3_finalize(stmt);
+    return ok;
+}
+
+} // namespace
+
+BulkImporter::BulkImporter(const std::string& dbPath, const ImportOptions& options)
+    : dbPath(dbPath), options(options) {}
+
+bool BulkImporter::run(ImportKind kind, const std::string& csvPath, ImportStats& stats) {
+    std::ifstream in(csvPath, std::ios::binary);
+    if (!in) {
+        std::cerr << "Cannot open import file: " << csvPath << std::endl;
+        return false;
+    }
+
+    StorageOptions storage;
+    storage.cacheSizeKiB = 256 * 1024;
+    Connection conn;
+    if (!conn.open(dbPath, SQLITE_OPEN_READWRITE, storage)) return false;
+    exec(conn.db, "PRAGMA foreign_keys = ON;");
+    exec(conn.db, "PRAGMA temp_store = MEMORY;");
+
+    const char* table = kind == ImportKind::Books ? "books" : kind == ImportKind::Members ? "members" : "loans";
+
+    // Maintaining indexes row by row is far slower than building them once over the sorted data. The
+    // full-text index and the loan counters are rebuilt the same way, with their triggers off while
+    // rows stream in.
+    std::vector<SchemaDefinition> indexes;
+    std::vector<SchemaDefinition> searchTriggers;
+    std::vector<SchemaDefinition> counterTriggers;
+    if (options.rebuildIndexes) {
+        indexes = schemaObjects(conn.db, "index", table);
+        searchTriggers = schemaObjects(conn.db, "trigger", table, std::string(table) + "_fts_");
+        counterTriggers = schemaObjects(conn.db, "trigger", table, std::string(table) + "_counters_");
+        bool dropped = exec(conn.db, "BEGIN IMMEDIATE;") &&
+                       exec(conn.db, "CREATE TABLE IF NOT EXISTS import_dropped (name TEXT PRIMARY KEY, sql TEXT NOT NULL);");
+        for (const auto& index : indexes) dropped = dropped && dropRecorded(conn.db, "INDEX", index);
+        for (const auto& trigger : searchTriggers) dropped = dropped && dropRecorded(conn.db, "TRIGGER", trigger);
+        for (const auto& trigger : counterTriggers) dropped = dropped && dropRecorded(conn.db, "TRIGGER", trigger);
+        if (!dropped || !exec(conn.db, "COMMIT;")) {
+            exec(conn.db, "ROLLBACK;");
+            std::cerr << "Could not drop the indexes of " << table << " for the import" << std::endl;
+            return false;
+        }
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    bool ok = false;
+    switch (kind) {
+        case ImportKind::Books:
+            ok = runPipeline<BookRow>(conn.db, in, options,
+                "INSERT INTO books (isbn, title, author, genre, publication_year, total_copies, available_copies, status) "
+                "VALUES (?, ?, ?, ?, ?, ?, ?, ?)", parseBook, stats);
+            break;
+        case ImportKind::Members:
+            ok = runPipeline<MemberRow>(conn.db, in, options,
+                "INSERT INTO members (name, email, phone, member_type, max_books_allowed) VALUES (?, ?, ?, ?, ?)",
+                parseMember, stats);
+            break;
+        case ImportKind::Loans:
+            ok = runPipeline<LoanRow>(conn.db, in, options,
+                "INSERT INTO loans (book_isbn, member_id, loan_date, due_date, return_date, is_returned, fine_amount) "
+                "VALUES (?, ?, ?, ?, ?, ?, ?)", parseLoan, stats);
+            break;
+    }
+
+    if (!indexes.empty()) {
+        std::cout << "  rebuilding " << indexes.size() << " index(es) on " << table << std::endl;
+        for (const auto& index : indexes) {
+            if (!restoreRecorded(conn.db, index)) ok = false;
+        }
+    }
+
+    if (!searchTriggers.empty()) {
+        std::cout << "  rebuilding the search index on " << table << std::endl;
+        if (!exec(conn.db, std::string("INSERT INTO ") + table + "_fts (" + table + "_fts) VALUES ('rebuild');")) ok = false;
+        for (const auto& trigger : searchTriggers) {
+            if (!restoreRecorded(conn.db, trigger)) ok = false;
+        }
+    }
+
+    // Batches commit one by one, so loans imported before a failure are in the table either way:
+    // recompute the counters whenever loans were imported, together with restoring their triggers
+    if (kind == ImportKind::Loans || !counterTriggers.empty()) {
+        bool counters = exec(conn.db, "BEGIN IMMEDIATE;");
+        if (counters && kind == ImportKind::Loans) {
+            // Imported active loans hold copies and count against their members, and imported fines
+            // are outstanding: recompute the counters of the affected books and members in one pass each
+            counters = exec(conn.db, R"(
+                UPDATE books
+                SET available_copies = MAX(0, books.total_copies - active.loans),
+                    status = CASE WHEN books.total_copies - active.loans > 0 THEN 0 ELSE 1 END
+                FROM (SELECT book_isbn, COUNT(*) AS loans FROM loans WHERE is_returned = 0 GROUP BY book_isbn) AS active
+                WHERE books.isbn = active.book_isbn;
+                UPDATE members
+                SET active_loans = c.active, outstanding_fines = c.fines
+                FROM (SELECT member_id, SUM(is_returned = 0) AS active, SUM(fine_amount) AS fines
+                      FROM loans GROUP BY member_id) AS c
+                WHERE members.id = c.member_id;
+            )");
+        }
+        for (const auto& trigger : counterTriggers) {
+            counters = counters && restoreRecorded(conn.db, trigger);
+        }
+        if (!counters || !exec(conn.db, "COMMIT;")) {
+            exec(conn.db, "ROLLBACK;");
+            std::cerr << "Loan counters were not rebuilt; checkouts may see wrong copy counts until "
+                         "LibrarySystem --reconcile is run" << std::endl;
+            ok = false;
+        }
+    }
+    if (options.rebuildIndexes) {
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(conn.db, "SELECT COUNT(*) FROM import_dropped", -1, &stmt, nullptr) == SQLITE_OK &&
+            sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_int(stmt, 0) > 0) {
+            std::cerr << sqlite3_column_int(stmt, 0) << " index(es) or trigger(s) dropped for the import were not "
+                         "rebuilt; fix the cause and run LibrarySystem --reconcile" << std::endl;
+        }
+        sqlite3_finalize(stmt);
+    }
+    if (ok) exec(conn.db, std::string("ANALYZE ") + table + ";");
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return ok;
+}
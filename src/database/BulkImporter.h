@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "ConnectionPool.h"
+
+enum class ImportKind { Books, Members, Loans };
+
+struct ImportOptions {
+    int parserThreads = 0;             // 0 = one per hardware thread, minus the reader and the writer
+    std::size_t chunkRows = 4096;      // rows handed to a parser at a time
+    std::size_t queueChunks = 8;       // chunks buffered between stages; bounds memory use
+    std::size_t batchRows = 50000;     // rows per transaction
+    bool hasHeader = true;
+    bool rebuildIndexes = true;        // drop secondary indexes of the target table and rebuild at the end
+};
+
+struct ImportStats {
+    std::size_t rowsRead = 0;
+    std::size_t rowsImported = 0;
+    std::size_t rowsRejected = 0;
+    double seconds = 0.0;
+    std::vector<std::string> sampleErrors;   // first few rejects, "line N: reason"
+
+    double rowsPerSecond() const { return seconds > 0.0 ? rowsImported / seconds : 0.0; }
+};
+
+// Streams a CSV file into one table. A reader thread splits the file into chunks, parser threads turn
+// them into validated rows, and the calling thread inserts them in large transactions through a single
+// prepared statement. Expected columns (extra columns are ignored):
+//   books:   isbn, title, author, genre, publication_year, total_copies[, available_copies]
+//   members: name, email, phone, member_type (0-2 or student/faculty/external)[, max_books_allowed]
+//   loans:   book_isbn, member_id, loan_date, due_date[, return_date[, fine_amount]]
+// Dates are unix seconds or YYYY-MM-DD; an empty return_date marks the loan as still active.
+// The schema must already exist (open the file with DatabaseManager first). Indexes and triggers dropped
+// for the import are recorded in import_dropped until rebuilt; DatabaseManager::reconcileCounters()
+// restores any that a failed or interrupted import left out.
+class BulkImporter {
+private:
+    std::string dbPath;
+    ImportOptions options;
+
+public:
+    BulkImporter(const std::string& dbPath, const ImportOptions& options = ImportOptions());
+
+    bool run(ImportKind kind, const std::string& csvPath, ImportStats& stats);
+};
@@ -0,0 +1,135 @@
+#include "ConnectionPool.h"
+#include <iostream>
+#include <utility>
+
+StorageOptions StorageOptions::wal() {
+    StorageOptions options;
+    options.walMode = true;
+    options.synchronous = "NORMAL";
+    options.mmapSize = 256LL * 1024 * 1024;
+    options.cacheSizeKiB = 64 * 1024;
+    options.readerConnections = 4;
+    return options;
+}
+
+static bool applyPragma(sqlite3* db, const std::string& sql) {
+    char* err = nullptr;
+    if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &err) != SQLITE_OK) {
+        std::cerr << "SQLite pragma failed (" << sql << "): " << (err ? err : "unknown") << std::endl;
+        if (err) sqlite3_free(err);
+        return false;
+    }
+    return true;
+}
+
+bool Connection::open(const std::string& path, int flags, const StorageOptions& options) {
+    if (sqlite3_open_v2(path.c_str(), &db, flags, nullptr) != SQLITE_OK) {
+        std::cerr << "Не вдалося відкрити базу даних: "
+                  << (db ? sqlite3_errmsg(db) : "unknown") << std::endl;
+        close();
+        return false;
+    }
+    statements.attach(db);
+    sqlite3_busy_timeout(db, options.busyTimeoutMs);
+
+    // Per-connection tuning; journal_mode and synchronous are applied by the owner of the write connection.
+    applyPragma(db, "PRAGMA cache_size = -" + std::to_string(options.cacheSizeKiB) + ";");
+    if (options.mmapSize > 0) {
+        applyPragma(db, "PRAGMA mmap_size = " + std::to_string(options.mmapSize) + ";");
+    }
+    return true;
+}
+
+void Connection::close() {
+    statements.clear();
+    if (db) {
+        sqlite3_close(db);
+        db = nullptr;
+    }
+}
+
+void SharedConnection::lock() {
+    mutex.lock();
+    if (depth++ == 0) holder.store(std::this_thread::get_id());
+}
+
+void SharedConnection::unlock() {
+    if (--depth == 0) holder.store(std::thread::id());
+    mutex.unlock();
+}
+
+bool ConnectionPool::open(const std::string& path, int count, const StorageOptions& options) {
+    close();
+    for (int i = 0; i < count; ++i) {
+        auto connection = std::make_unique<Connection>();
+        if (!connection->open(path, SQLITE_OPEN_READONLY, options)) {
+            close();
+            return false;
+        }
+        connections.push_back(std::move(connection));
+    }
+    return true;
+}
+
+void ConnectionPool::close() {
+    std::lock_guard<std::mutex> guard(mutex);
+    for (auto& connection : connections) connection->close();
+    connections.clear();
+}
+
+void ConnectionPool::forEach(const std::function<void(Connection&)>& visit) {
+    std::lock_guard<std::mutex> guard(mutex);
+    for (auto& connection : connections) visit(*connection);
+}
+
+Connection* ConnectionPool::acquire() {
+    std::unique_lock<std::mutex> guard(mutex);
+    const auto self = std::this_thread::get_id();
+    for (auto& connection : connections) {
+        if (connection->leaseDepth > 0 && connection->leasedBy == self) {
+            ++connection->leaseDepth;
+            return connection.get();
+        }
+    }
+
+    Connection* result = nullptr;
+    available.wait(guard, [&] {
+        for (auto& connection : connections) {
+            if (connection->leaseDepth == 0) {
+                result = connection.get();
+                return true;
+            }
+        }
+        return false;
+    });
+    result->leasedBy = self;
+    result->leaseDepth = 1;
+    return result;
+}
+
+void ConnectionPool::release(Connection* connection) {
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (--connection->leaseDepth > 0) return;
+        connection->leasedBy = std::thread::id();
+    }
+    available.notify_one();
+}
+
+ConnectionLease::ConnectionLease(SharedConnection& primary) : connection(&primary), shared(&primary) {
+    primary.lock();
+}
+
+ConnectionLease::ConnectionLease(ConnectionPool& readers) : pool(&readers) {
+    connection = readers.acquire();
+}
+
+ConnectionLease::ConnectionLease(ConnectionLease&& other) noexcept
+    : connection(std::exchange(other.connection, nullptr)),
+      shared(std::exchange(other.shared, nullptr)),
+      pool(std::exchange(other.pool, nullptr)) {}
+
+ConnectionLease::~ConnectionLease() {
+    if (shared) shared->unlock();
+    else if (pool) pool->release(connection);
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <sqlite3.h>
+#include "StatementCache.h"
+
+// Opt-in storage tuning. The defaults keep the rollback journal and a single connection, which is
+// how the database has always been opened.
+struct StorageOptions {
+    bool walMode = false;
+    // FULL syncs on every commit. NORMAL is safe with WAL: a power loss may drop the last commits,
+    // but never corrupts the file.
+    std::string synchronous = "FULL";
+    std::int64_t mmapSize = 0;        // bytes; 0 disables memory-mapped I/O
+    int cacheSizeKiB = 2000;          // page cache per connection
+    int readerConnections = 0;        // read-only connections for non-desk threads (WAL only)
+    int busyTimeoutMs = 5000;
+    int slowQueryMs = 0;              // statements slower than this go to the slow-query log; 0 leaves tracing off
+
+    // WAL with NORMAL sync, a 256 MiB mmap window, a 64 MiB cache and four readers.
+    static StorageOptions wal();
+};
+
+struct Connection {
+    sqlite3* db = nullptr;
+    StatementCache statements;
+    std::thread::id leasedBy;
+    int leaseDepth = 0;
+
+    bool open(const std::string& path, int flags, const StorageOptions& options);
+    void close();
+};
+
+// The read-write connection. Threads take turns on it through a recursive mutex, so a write can call
+// read helpers inside its own transaction.
+class SharedConnection : public Connection {
+private:
+    std::recursive_mutex mutex;
+    std::atomic<std::thread::id> holder;
+    int depth = 0;
+
+public:
+    void lock();
+    void unlock();
+    bool heldByCurrentThread() const { return holder.load() == std::this_thread::get_id(); }
+};
+
+// Fixed set of read-only connections. A thread keeps the same connection while it holds any lease,
+// so nested reads on one thread never wait on each other.
+class ConnectionPool {
+private:
+    std::vector<std::unique_ptr<Connection>> connections;
+    std::mutex mutex;
+    std::condition_variable available;
+
+public:
+    ConnectionPool() = default;
+    ~ConnectionPool() { close(); }
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    bool open(const std::string& path, int count, const StorageOptions& options);
+    void close();
+    bool empty() const { return connections.empty(); }
+    // Visits every connection, leased or not; only for calls SQLite serializes itself
+    void forEach(const std::function<void(Connection&)>& visit);
+
+    Connection* acquire();
+    void release(Connection* connection);
+};
+
+// Scoped access to either the shared read-write connection or a pooled reader.
+class ConnectionLease {
+private:
+    Connection* connection = nullptr;
+    SharedConnection* shared = nullptr;
+    ConnectionPool* pool = nullptr;
+
+public:
+    explicit ConnectionLease(SharedConnection& primary);
+    explicit ConnectionLease(ConnectionPool& readers);
+    ConnectionLease(ConnectionLease&& other) noexcept;
+    ConnectionLease(const ConnectionLease&) = delete;
+    ConnectionLease& operator=(const ConnectionLease&) = delete;
+    ConnectionLease& operator=(ConnectionLease&&) = delete;
+    ~ConnectionLease();
+
+    Connection* operator->() const { return connection; }
+    Connection& operator*() const { return *connection; }
+};
@@ -2,42 +2,100 @@
 #include <iostream>
 #include <chrono>
 #include <optional>
+#include <algorithm>
+#include <cstring>
+#include <cctype>
+#include <cstdio>
+#include <iterator>
+#include <filesystem>
 #include "../core/hash.h"
+#include "Transaction.h"
+#include "Migrations.h"
+#include "RowMapper.h"
 
 static inline std::int64_t timepoint_to_seconds(const std::chrono::system_clock::time_point& tp) {
     return std::chrono::duration_cast<std::chrono::seconds>(tp.time_since_epoch()).count();
 }
-static inline std::chrono::system_clock::time_point seconds_to_timepoint(std::int64_t s) {
-    return std::chrono::system_clock::time_point(std::chrono::seconds(s));
-}
 
-DatabaseManager::DatabaseManager(const std::string& path) : dbPath(path), db(nullptr) {
+// Row types local to this file; Book, Member and Loan are mapped in RowMapper.h
+template <>
+struct RowMapping<LoanView> {
+    // the loan's columns, then b.title, m.name
+    static LoanView make(Loan loan, std::string bookTitle, std::string memberName) {
+        return { std::move(loan), std::move(bookTitle), std::move(memberName) };
+    }
+};
+
+template <>
+struct RowMapping<BookListItem> {
+    // isbn, title, author, publication_year, total_copies, available_copies, status
+    static BookListItem make(std::string isbn, std::string title, std::string author, int publicationYear,
+                             int totalCopies, int availableCopies, Book::Status status) {
+        return { std::move(isbn), std::move(title), std::move(author), publicationYear, totalCopies, availableCopies, status };
+    }
+};
+
+template <>
+struct RowMapping<MemberListItem> {
+    // id, name, phone, max_books_allowed
+    static MemberListItem make(int id, std::string name, std::string phone, int maxBooksAllowed) {
+        return { id, std::move(name), std::move(phone), maxBooksAllowed };
+    }
+};
+
+template <>
+struct RowMapping<MemberLoanCounts> {
+    static MemberLoanCounts make(int memberId, int active, int overdue) {
+        return { memberId, active, overdue };
+    }
+};
+
+template <>
+struct RowMapping<MemberTypeTotals> {
+    static MemberTypeTotals make(Member::Type type, int members, int activeLoans, int overdueLoans) {
+        return { type, members, activeLoans, overdueLoans };
+    }
+};
+
+template <>
+struct RowMapping<MemberFineReport> {
+    static MemberFineReport make(int memberId, std::string name, int loans, int lateReturns, double fines) {
+        return { memberId, std::move(name), loans, lateReturns, fines };
+    }
+};
+
+template <>
+struct RowMapping<CirculationMonth> {
+    static CirculationMonth make(std::string month, int loans, int returned, int lateReturns, double fines) {
+        return { std::move(month), loans, returned, lateReturns, fines };
+    }
+};
+
+DatabaseManager::DatabaseManager(const std::string& path, const StorageOptions& storage)
+    : dbPath(path), options(storage), deskThread(std::this_thread::get_id()) {
     initialize();
 }
 
 bool DatabaseManager::validateLogin(const std::string& username, const std::string& password, int& outUserId) {
-    sqlite3_stmt* stmt = nullptr;
-    std::string query = "SELECT id, password_hash FROM users WHERE username = ? LIMIT 1";
-
-    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "SQLite prepare failed (validateLogin): " << sqlite3_errmsg(db) << std::endl;
+    QueryTimer timer(stats, DbMethod::ValidateLogin);
+    ConnectionLease conn = readConnection();
+    const char* sql = "SELECT id, password_hash FROM users WHERE username = ? LIMIT 1";
+    CachedStatement stmt = conn->statements.acquire(sql);
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (validateLogin): " << sqlite3_errmsg(conn->db) << std::endl;
         return false;
     }
 
-    sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_TRANSIENT);
+    bindParams(stmt, username);
 
     int rc = sqlite3_step(stmt);
     if (rc != SQLITE_ROW) {
         std::cerr << "User not found or step failed: rc=" << rc << std::endl;
-        sqlite3_finalize(stmt);
         return false;
     }
 
-    int userId = sqlite3_column_int(stmt, 0);
-    const unsigned char* storedHashC = sqlite3_column_text(stmt, 1);
-    std::string storedHash = storedHashC ? reinterpret_cast<const char*>(storedHashC) : "";
-
-    sqlite3_finalize(stmt);
+    auto [userId, storedHash] = readRow<int, std::string>(stmt);
+    stmt.release();
 
     std::string inputHash = sha256(password);
 
@@ -54,30 +112,108 @@ bool DatabaseManager::validateLogin(const std::string& username, const std::stri
 }
 
 DatabaseManager::~DatabaseManager() {
-    if (db) {
-        sqlite3_close(db);
-        db = nullptr;
-    }
+    readers.close();
+    primary.close();
 }
 
 bool DatabaseManager::initialize() {
-    if (sqlite3_open(dbPath.c_str(), &db) != SQLITE_OK) {
-        std::cerr << "Не вдалося відкрити базу даних: "
-                  << (db ? sqlite3_errmsg(db) : "unknown") << std::endl;
+    QueryTimer timer(stats, DbMethod::Initialize);
+    if (!primary.open(dbPath, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, options)) {
         return false;
     }
+    sqlite3_update_hook(primary.db, &DatabaseManager::onRowChanged, this);
+
+    if (options.walMode && !executeSQL("PRAGMA journal_mode = WAL;")) {
+        std::cerr << "Could not switch to WAL, staying on the rollback journal" << std::endl;
+    }
+    if (!executeSQL("PRAGMA synchronous = " + options.synchronous + ";")) {
+        std::cerr << "Could not set PRAGMA synchronous" << std::endl;
+    }
 
     // Ensure foreign keys enforced
     if (!executeSQL("PRAGMA foreign_keys = ON;")) {
         std::cerr << "Could not enable PRAGMA foreign_keys" << std::endl;
     }
 
-    return createTables();
+    // A current file only needs this read. Index-only steps are left to runPendingMigrations().
+    int version = schemaVersion();
+    if (version < 0) {
+        return false;
+    }
+    if (version > latestSchemaVersion()) {
+        std::cerr << "Database schema version " << version << " is newer than this build knows" << std::endl;
+    }
+    if (version < requiredSchemaVersion() && !migrateTo(requiredSchemaVersion(), false)) {
+        return false;
+    }
+    fullTextSearch = hasSearchIndex();
+    if (int missing = static_cast<int>(droppedByImport().size()); missing > 0) {
+        std::cerr << "An import into this file did not finish: " << missing << " index(es) or trigger(s) are missing "
+                  << "and the loan counters may be wrong. Run LibrarySystem --reconcile" << std::endl;
+    }
+    if (!migrationsPending() && !checkQueryPlans()) {
+        std::cerr << "Some hot queries fall back to table scans, see above" << std::endl;
+    }
+
+    // Readers only pay off in WAL mode, where they do not block (and are not blocked by) the writer.
+    if (options.walMode && options.readerConnections > 0 &&
+        !readers.open(dbPath, options.readerConnections, options)) {
+        std::cerr << "Could not open reader connections, all reads will use the main connection" << std::endl;
+    }
+
+    if (!dbPath.empty() && dbPath != ":memory:") {
+        slowQueries.setFile(std::filesystem::path(dbPath).replace_extension(".slow.log").string());
+    }
+    if (options.slowQueryMs > 0) {
+        setSlowQueryThreshold(std::chrono::milliseconds(options.slowQueryMs));
+    }
+    return true;
+}
+
+// The desk thread, and any thread already inside a write, reads through the main connection so it
+// sees its own uncommitted changes. Other threads get a pooled read-only connection when available.
+ConnectionLease DatabaseManager::readConnection() {
+    if (readers.empty() || std::this_thread::get_id() == deskThread || primary.heldByCurrentThread()) {
+        return ConnectionLease(primary);
+    }
+    return ConnectionLease(readers);
+}
+
+ConnectionLease DatabaseManager::writeConnection() {
+    return ConnectionLease(primary);
+}
+
+void DatabaseManager::onRowChanged(void* self, int, const char*, const char* table, sqlite3_int64) {
+    static const char* const names[] = { "books", "members", "loans", "users" };
+    auto* manager = static_cast<DatabaseManager*>(self);
+    for (int i = 0; i < static_cast<int>(DataTable::Count); ++i) {
+        if (std::strcmp(table, names[i]) == 0) {
+            manager->tableWrites[i].fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+void DatabaseManager::setSlowQueryThreshold(std::chrono::milliseconds threshold) {
+    bool wasEnabled = slowQueries.enabled();
+    slowQueries.setThreshold(threshold);
+    if (slowQueries.enabled() == wasEnabled) return;
+
+    auto apply = [this](Connection& connection) {
+        if (slowQueries.enabled()) slowQueries.attach(connection.db);
+        else SlowQueryLog::detach(connection.db);
+    };
+    {
+        ConnectionLease conn = writeConnection();
+        apply(*conn);
+    }
+    readers.forEach(apply);
 }
 
 bool DatabaseManager::executeSQL(const std::string& sql) {
+    ConnectionLease conn = writeConnection();
     char* err = nullptr;
-    if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &err) != SQLITE_OK) {
+    if (sqlite3_exec(conn->db, sql.c_str(), nullptr, nullptr, &err) != SQLITE_OK) {
         std::cerr << "SQLite exec failed: " << (err ? err : "unknown") << std::endl;
         if (err) sqlite3_free(err);
         return false;
@@ -85,486 +221,1750 @@ bool DatabaseManager::executeSQL(const std::string& sql) {
     return true;
 }
 
-bool DatabaseManager::createTables() {
-    const char* books_sql = R"(
-        CREATE TABLE IF NOT EXISTS books (
-            isbn TEXT PRIMARY KEY,
-            title TEXT NOT NULL,
-            author TEXT NOT NULL,
-            genre TEXT,
-            publication_year INTEGER,
-            total_copies INTEGER,
-            available_copies INTEGER,
-            status INTEGER
-        );
-    )";
+int DatabaseManager::schemaVersion() {
+    QueryTimer timer(stats, DbMethod::SchemaVersion);
+    ConnectionLease conn = readConnection();
+    CachedStatement stmt = conn->statements.acquire("PRAGMA user_version");
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (schemaVersion): " << sqlite3_errmsg(conn->db) << std::endl;
+        return -1;
+    }
+    return sqlite3_step(stmt) == SQLITE_ROW ? readColumn<int>(stmt, 0) : -1;
+}
 
-    const char* members_sql = R"(
-        CREATE TABLE IF NOT EXISTS members (
-            id INTEGER PRIMARY KEY AUTOINCREMENT,
-            name TEXT NOT NULL,
-            email TEXT UNIQUE,
-            phone TEXT,
-            member_type INTEGER,
-            max_books_allowed INTEGER
-        );
-    )";
+// Applies the steps after the current version up to `target`, leaving out background ones unless
+// asked for. Each step commits with its version record, so a failure leaves the file at the last
+// complete step and the rest is retried next launch. A failed background step does not hold back the
+// steps after it: without FTS5 the search index cannot be built and book search stays on LIKE scans.
+bool DatabaseManager::migrateTo(int target, bool background) {
+    bool ok = true;
+    for (const Migration& migration : schemaMigrations()) {
+        if (migration.version > target) break;
+        if (migration.background && !background) continue;
+        if (migrationApplied(migration.version)) continue;
 
-    const char* loans_sql = R"(
-        CREATE TABLE IF NOT EXISTS loans (
-            id INTEGER PRIMARY KEY AUTOINCREMENT,
-            book_isbn TEXT NOT NULL,
-            member_id INTEGER NOT NULL,
-            loan_date INTEGER NOT NULL,
-            due_date INTEGER NOT NULL,
-            return_date INTEGER,
-            is_returned INTEGER DEFAULT 0,
-            fine_amount REAL DEFAULT 0.0,
-            FOREIGN KEY (book_isbn) REFERENCES books (isbn) ON DELETE CASCADE,
-            FOREIGN KEY (member_id) REFERENCES members (id) ON DELETE CASCADE
-        );
-    )";
+        ConnectionLease conn = writeConnection();
+        Transaction tx(conn->db);
+        if (!tx) return false;
+        // Another desk may have applied the step while this one waited for the write lock
+        if (migrationApplied(migration.version)) continue;
 
-    const char* users_sql = R"(
-        CREATE TABLE IF NOT EXISTS users (
-            id INTEGER PRIMARY KEY AUTOINCREMENT,
-            username TEXT UNIQUE NOT NULL,
-            password_hash TEXT NOT NULL
-        );
-    )";
+        if (!executeSQL(migration.sql) || !recordMigration(migration.version) || !tx.commit()) {
+            std::cerr << "Schema migration " << migration.version << " (" << migration.description << ") failed" << std::endl;
+            if (!migration.background) return false;
+            ok = false;
+            continue;
+        }
+        std::cout << "Schema migrated to version " << migration.version << " (" << migration.description << ")" << std::endl;
+    }
+    return ok;
+}
+
+bool DatabaseManager::migrationApplied(int version) {
+    if (version <= schemaVersion()) return true;
+    std::vector<int> ahead = stepsAhead();
+    return std::find(ahead.begin(), ahead.end(), version) != ahead.end();
+}
+
+// Steps applied while an earlier background step was still pending, in version order. user_version
+// cannot move past the gap, so they are listed in schema_steps until it closes.
+std::vector<int> DatabaseManager::stepsAhead() {
+    std::vector<int> versions;
+    ConnectionLease conn = readConnection();
+    CachedStatement exists = conn->statements.acquire("SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'schema_steps'");
+    if (!exists || sqlite3_step(exists) != SQLITE_ROW) return versions;
+
+    CachedStatement stmt = conn->statements.acquire("SELECT version FROM schema_steps ORDER BY version");
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (stepsAhead): " << sqlite3_errmsg(conn->db) << std::endl;
+        return versions;
+    }
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        versions.push_back(readColumn<int>(stmt, 0));
+    }
+    return versions;
+}
+
+// Marks `version` applied inside the migration's transaction. The step right after user_version
+// advances it, along with any steps already waiting in schema_steps; any other step is listed there.
+bool DatabaseManager::recordMigration(int version) {
+    int current = schemaVersion();
+    if (current < 0) return false;
+    if (version != current + 1) {
+        return executeSQL("CREATE TABLE IF NOT EXISTS schema_steps (version INTEGER PRIMARY KEY);"
+                          "INSERT OR IGNORE INTO schema_steps (version) VALUES (" + std::to_string(version) + ");");
+    }
 
-    if (!(executeSQL(books_sql) && executeSQL(members_sql) && executeSQL(loans_sql) && executeSQL(users_sql))) {
+    int reached = version;
+    for (int ahead : stepsAhead()) {
+        if (ahead == reached + 1) reached = ahead;
+    }
+    if (reached > version && !executeSQL("DELETE FROM schema_steps WHERE version <= " + std::to_string(reached) + ";")) {
         return false;
     }
+    return executeSQL("PRAGMA user_version = " + std::to_string(reached) + ";");
+}
 
-    const char* insertAdmin = R"(
-        INSERT INTO users (username, password_hash)
-        VALUES ('admin', '8c6976e5b5410415bde908bd4dee15dfb167a9c873fc4bb8a81f6f2ab448a918')
-        ON CONFLICT(username) DO UPDATE SET password_hash=excluded.password_hash;
-    )";
+bool DatabaseManager::migrationsPending() {
+    QueryTimer timer(stats, DbMethod::MigrationsPending);
+    return schemaVersion() < latestSchemaVersion();
+}
+
+bool DatabaseManager::runPendingMigrations() {
+    QueryTimer timer(stats, DbMethod::RunPendingMigrations);
+    if (!migrationsPending()) return true;
+    bool ok = migrateTo(latestSchemaVersion(), true);
+    fullTextSearch = hasSearchIndex();
+    if (ok && !checkQueryPlans()) {
+        std::cerr << "Some hot queries fall back to table scans, see above" << std::endl;
+    }
+    return ok;
+}
+
+bool DatabaseManager::hasSearchIndex() {
+    ConnectionLease conn = readConnection();
+    CachedStatement stmt = conn->statements.acquire("SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'books_fts'");
+    return stmt && sqlite3_step(stmt) == SQLITE_ROW;
+}
 
-    return executeSQL(insertAdmin);
+bool DatabaseManager::rebuildSearchIndex() {
+    QueryTimer timer(stats, DbMethod::RebuildSearchIndex);
+    return fullTextSearch && executeSQL("INSERT INTO books_fts (books_fts) VALUES ('rebuild');");
+}
+
+bool DatabaseManager::updateStatistics() {
+    QueryTimer timer(stats, DbMethod::UpdateStatistics);
+    return executeSQL("ANALYZE;");
 }
 
 bool DatabaseManager::addBook(const Book& book) {
+    QueryTimer timer(stats, DbMethod::AddBook);
+    ConnectionLease conn = writeConnection();
     const char* sql =
         "INSERT INTO books (isbn, title, author, genre, publication_year, total_copies, available_copies, status) "
         "VALUES (?, ?, ?, ?, ?, ?, ?, ?)";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "SQLite prepare failed (addBook): " << sqlite3_errmsg(db) << std::endl;
+    CachedStatement stmt = conn->statements.acquire(sql);
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (addBook): " << sqlite3_errmsg(conn->db) << std::endl;
         return false;
     }
-    sqlite3_bind_text(stmt, 1, book.getISBN().c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 2, book.getTitle().c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 3, book.getAuthor().c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 4, book.getGenre().c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_int(stmt, 5, book.getPublicationYear());
-    sqlite3_bind_int(stmt, 6, book.getTotalCopies());
-    sqlite3_bind_int(stmt, 7, book.getAvailableCopies());
-    sqlite3_bind_int(stmt, 8, static_cast<int>(book.getStatus()));
+    bindParams(stmt, book.getISBN(), book.getTitle(), book.getAuthor(), book.getGenre(),
+               book.getPublicationYear(), book.getTotalCopies(), book.getAvailableCopies(), book.getStatus());
 
     bool ok = sqlite3_step(stmt) == SQLITE_DONE;
-    if (!ok) std::cerr << "SQLite step failed (addBook): " << sqlite3_errmsg(db) << std::endl;
-    sqlite3_finalize(stmt);
+    if (!ok) std::cerr << "SQLite step failed (addBook): " << sqlite3_errmsg(conn->db) << std::endl;
+    if (ok) timer.rows(sqlite3_changes(conn->db));
     return ok;
 }
 
 bool DatabaseManager::updateBook(const Book& book) {
-    const char* sql =
-        "UPDATE books SET title=?, author=?, genre=?, publication_year=?, total_copies=?, available_copies=?, status=? WHERE isbn=?";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "SQLite prepare failed (updateBook): " << sqlite3_errmsg(db) << std::endl;
+    QueryTimer timer(stats, DbMethod::UpdateBook);
+    ConnectionLease conn = writeConnection();
+    // The loan triggers own available_copies, so a change of total_copies moves the stock by the
+    // difference instead of writing back a count read when the editor opened.
+    const char* sql = R"(
+        UPDATE books
+        SET title = ?1, author = ?2, genre = ?3, publication_year = ?4,
+            available_copies = MAX(0, MIN(?5, available_copies + (?5 - total_copies))),
+            status = CASE WHEN available_copies + (?5 - total_copies) > 0 THEN 0 ELSE 1 END,
+            total_copies = ?5
+        WHERE isbn = ?6
+    )";
+    CachedStatement stmt = conn->statements.acquire(sql);
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (updateBook): " << sqlite3_errmsg(conn->db) << std::endl;
         return false;
     }
-    sqlite3_bind_text(stmt, 1, book.getTitle().c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 2, book.getAuthor().c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 3, book.getGenre().c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_int(stmt, 4, book.getPublicationYear());
-    sqlite3_bind_int(stmt, 5, book.getTotalCopies());
-    sqlite3_bind_int(stmt, 6, book.getAvailableCopies());
-    sqlite3_bind_int(stmt, 7, static_cast<int>(book.getStatus()));
-    sqlite3_bind_text(stmt, 8, book.getISBN().c_str(), -1, SQLITE_TRANSIENT);
+    bindParams(stmt, book.getTitle(), book.getAuthor(), book.getGenre(), book.getPublicationYear(),
+               book.getTotalCopies(), book.getISBN());
 
     bool ok = sqlite3_step(stmt) == SQLITE_DONE;
-    if (!ok) std::cerr << "SQLite step failed (updateBook): " << sqlite3_errmsg(db) << std::endl;
-    sqlite3_finalize(stmt);
+    if (!ok) std::cerr << "SQLite step failed (updateBook): " << sqlite3_errmsg(conn->db) << std::endl;
+    if (ok) timer.rows(sqlite3_changes(conn->db));
     return ok;
 }
 
 bool DatabaseManager::deleteBook(const std::string& isbn) {
+    QueryTimer timer(stats, DbMethod::DeleteBook);
+    ConnectionLease conn = writeConnection();
     const char* sql = "DELETE FROM books WHERE isbn = ?";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "SQLite prepare failed (deleteBook): " << sqlite3_errmsg(db) << std::endl;
+    CachedStatement stmt = conn->statements.acquire(sql);
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (deleteBook): " << sqlite3_errmsg(conn->db) << std::endl;
         return false;
     }
-    sqlite3_bind_text(stmt, 1, isbn.c_str(), -1, SQLITE_TRANSIENT);
+    bindParams(stmt, isbn);
     bool ok = sqlite3_step(stmt) == SQLITE_DONE;
-    if (!ok) std::cerr << "SQLite step failed (deleteBook): " << sqlite3_errmsg(db) << std::endl;
-    sqlite3_finalize(stmt);
+    if (!ok) std::cerr << "SQLite step failed (deleteBook): " << sqlite3_errmsg(conn->db) << std::endl;
+    if (ok) timer.rows(sqlite3_changes(conn->db));
     return ok;
 }
 
 std::vector<Book> DatabaseManager::getAllBooks() {
+    QueryTimer timer(stats, DbMethod::GetAllBooks);
     std::vector<Book> books;
+    for (Book& book : openBookCursor()) {
+        books.push_back(std::move(book));
+    }
+    timer.rows(books.size());
+    return books;
+}
+
+RowCursor<Book> DatabaseManager::openBookCursor() {
+    QueryTimer timer(stats, DbMethod::OpenBookCursor);
+    ConnectionLease conn = readConnection();
     const char* sql = "SELECT isbn, title, author, genre, publication_year, total_copies, available_copies, status FROM books";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "SQLite prepare failed (getAllBooks): " << sqlite3_errmsg(db) << std::endl;
+    CachedStatement stmt = conn->statements.acquire(sql);
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (openBookCursor): " << sqlite3_errmsg(conn->db) << std::endl;
+    }
+    return RowCursor<Book>(std::move(conn), std::move(stmt));
+}
+
+bool DatabaseManager::forEachBook(const std::function<bool(const Book&)>& visitor) {
+    QueryTimer timer(stats, DbMethod::ForEachBook);
+    for (const Book& book : openBookCursor()) {
+        if (!visitor(book)) return false;
+    }
+    return true;
+}
+
+static const char* const BOOK_PAGE_SQL[3][2] = {
+    { "SELECT isbn, title, author, genre, publication_year, total_copies, available_copies, status FROM books "
+      "ORDER BY isbn LIMIT ?3",
+      "SELECT isbn, title, author, genre, publication_year, total_copies, available_copies, status FROM books "
+      "WHERE isbn > ?2 ORDER BY isbn LIMIT ?3" },
+    { "SELECT isbn, title, author, genre, publication_year, total_copies, available_copies, status FROM books "
+      "ORDER BY title, isbn LIMIT ?3",
+      "SELECT isbn, title, author, genre, publication_year, total_copies, available_copies, status FROM books "
+      "WHERE (title, isbn) > (?1, ?2) ORDER BY title, isbn LIMIT ?3" },
+    { "SELECT isbn, title, author, genre, publication_year, total_copies, available_copies, status FROM books "
+      "ORDER BY author, isbn LIMIT ?3",
+      "SELECT isbn, title, author, genre, publication_year, total_copies, available_copies, status FROM books "
+      "WHERE (author, isbn) > (?1, ?2) ORDER BY author, isbn LIMIT ?3" },
+};
+
+std::vector<Book> DatabaseManager::getBooksPage(const std::optional<BookPageKey>& after, int limit, BookSort sort) {
+    QueryTimer timer(stats, DbMethod::GetBooksPage);
+    ConnectionLease conn = readConnection();
+    std::vector<Book> books;
+    const char* sql = BOOK_PAGE_SQL[static_cast<int>(sort)][after ? 1 : 0];
+    CachedStatement stmt = conn->statements.acquire(sql);
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (getBooksPage): " << sqlite3_errmsg(conn->db) << std::endl;
         return books;
     }
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        const unsigned char* t0 = sqlite3_column_text(stmt, 0);
-        const unsigned char* t1 = sqlite3_column_text(stmt, 1);
-        const unsigned char* t2 = sqlite3_column_text(stmt, 2);
-        const unsigned char* t3 = sqlite3_column_text(stmt, 3);
-        std::string isbn = t0 ? reinterpret_cast<const char*>(t0) : std::string();
-        std::string title = t1 ? reinterpret_cast<const char*>(t1) : std::string();
-        std::string author = t2 ? reinterpret_cast<const char*>(t2) : std::string();
-        std::string genre = t3 ? reinterpret_cast<const char*>(t3) : std::string();
-        int pub = sqlite3_column_int(stmt, 4);
-        int total = sqlite3_column_int(stmt, 5);
-        int avail = sqlite3_column_int(stmt, 6);
-        int statusInt = sqlite3_column_int(stmt, 7);
-        books.emplace_back(isbn, title, author, genre, pub, total, avail, static_cast<Book::Status>(statusInt));
-    }
-    sqlite3_finalize(stmt);
+    if (after) bindParams(stmt, after->sortValue, after->isbn);
+    bindValue(stmt, 3, limit);
+    books.reserve(limit > 0 ? limit : 0);
+    readRows(stmt, books);
+    timer.rows(books.size());
+    return books;
+}
+
+BookPageKey DatabaseManager::bookPageKey(const Book& book, BookSort sort) {
+    switch (sort) {
+        case BookSort::Title: return { book.getTitle(), book.getISBN() };
+        case BookSort::Author: return { book.getAuthor(), book.getISBN() };
+        default: return { std::string(), book.getISBN() };
+    }
+}
+
+// BOOK_PAGE_SQL without the columns no list shows
+static const char* const BOOK_LIST_PAGE_SQL[3][2] = {
+    { "SELECT isbn, title, author, publication_year, total_copies, available_copies, status FROM books "
+      "ORDER BY isbn LIMIT ?3",
+      "SELECT isbn, title, author, publication_year, total_copies, available_copies, status FROM books "
+      "WHERE isbn > ?2 ORDER BY isbn LIMIT ?3" },
+    { "SELECT isbn, title, author, publication_year, total_copies, available_copies, status FROM books "
+      "ORDER BY title, isbn LIMIT ?3",
+      "SELECT isbn, title, author, publication_year, total_copies, available_copies, status FROM books "
+      "WHERE (title, isbn) > (?1, ?2) ORDER BY title, isbn LIMIT ?3" },
+    { "SELECT isbn, title, author, publication_year, total_copies, available_copies, status FROM books "
+      "ORDER BY author, isbn LIMIT ?3",
+      "SELECT isbn, title, author, publication_year, total_copies, available_copies, status FROM books "
+      "WHERE (author, isbn) > (?1, ?2) ORDER BY author, isbn LIMIT ?3" },
+};
+
+std::vector<BookListItem> DatabaseManager::getBookListPage(const std::optional<BookPageKey>& after, int limit, BookSort sort) {
+    QueryTimer timer(stats, DbMethod::GetBookListPage);
+    ConnectionLease conn = readConnection();
+    std::vector<BookListItem> books;
+    const char* sql = BOOK_LIST_PAGE_SQL[static_cast<int>(sort)][after ? 1 : 0];
+    CachedStatement stmt = conn->statements.acquire(sql);
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (getBookListPage): " << sqlite3_errmsg(conn->db) << std::endl;
+        return books;
+    }
+    if (after) bindParams(stmt, after->sortValue, after->isbn);
+    bindValue(stmt, 3, limit);
+    books.reserve(limit > 0 ? limit : 0);
+    readRows(stmt, books);
+    timer.rows(books.size());
+    return books;
+}
+
+BookPageKey DatabaseManager::bookPageKey(const BookListItem& book, BookSort sort) {
+    switch (sort) {
+        case BookSort::Title: return { book.title, book.isbn };
+        case BookSort::Author: return { book.author, book.isbn };
+        default: return { std::string(), book.isbn };
+    }
+}
+
+std::vector<BookListItem> DatabaseManager::getBookList(bool availableOnly) {
+    QueryTimer timer(stats, DbMethod::GetBookList);
+    ConnectionLease conn = readConnection();
+    std::vector<BookListItem> books;
+    const char* sql = availableOnly
+        ? "SELECT isbn, title, author, publication_year, total_copies, available_copies, status FROM books "
+          "WHERE status = 0 AND available_copies > 0"
+        : "SELECT isbn, title, author, publication_year, total_copies, available_copies, status FROM books";
+    CachedStatement stmt = conn->statements.acquire(sql);
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (getBookList): " << sqlite3_errmsg(conn->db) << std::endl;
+        return books;
+    }
+    readRows(stmt, books);
+    timer.rows(books.size());
+    return books;
+}
+
+int DatabaseManager::countBooks() {
+    QueryTimer timer(stats, DbMethod::CountBooks);
+    ConnectionLease conn = readConnection();
+    CachedStatement stmt = conn->statements.acquire("SELECT COUNT(*) FROM books");
+    return stmt && sqlite3_step(stmt) == SQLITE_ROW ? readColumn<int>(stmt, 0) : 0;
+}
+
+// Turns free text into an FTS5 query: every word becomes a quoted prefix term, and all must match.
+// Quoting keeps operators and punctuation typed by the user from being parsed as query syntax.
+static std::string toMatchQuery(const std::string& text) {
+    std::string query;
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+        while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) ++pos;
+        std::size_t end = pos;
+        bool hasToken = false;
+        while (end < text.size() && !std::isspace(static_cast<unsigned char>(text[end]))) {
+            unsigned char c = static_cast<unsigned char>(text[end]);
+            if (std::isalnum(c) || c >= 0x80) hasToken = true;
+            ++end;
+        }
+        if (hasToken) {
+            if (!query.empty()) query += ' ';
+            query += '"';
+            for (std::size_t i = pos; i < end; ++i) {
+                if (text[i] == '"') query += '"';
+                query += text[i];
+            }
+            query += "\"*";
+        }
+        pos = end;
+    }
+    return query;
+}
+
+// Title hits weigh more than author hits, which weigh more than ISBN fragments
+static const char* const BOOK_SEARCH_SQL =
+    "SELECT b.isbn, b.title, b.author, b.genre, b.publication_year, b.total_copies, b.available_copies, b.status "
+    "FROM books_fts JOIN books b ON b.rowid = books_fts.rowid "
+    "WHERE books_fts MATCH ?1 ORDER BY bm25(books_fts, 1.0, 10.0, 5.0) LIMIT ?2";
+static const char* const BOOK_LIST_SEARCH_SQL =
+    "SELECT b.isbn, b.title, b.author, b.publication_year, b.total_copies, b.available_copies, b.status "
+    "FROM books_fts JOIN books b ON b.rowid = books_fts.rowid "
+    "WHERE books_fts MATCH ?1 ORDER BY bm25(books_fts, 1.0, 10.0, 5.0) LIMIT ?2";
+// Pick lists offer only books with a copy on the shelf, as getBookList(true) does
+static const char* const BOOK_LIST_AVAILABLE_SEARCH_SQL =
+    "SELECT b.isbn, b.title, b.author, b.publication_year, b.total_copies, b.available_copies, b.status "
+    "FROM books_fts JOIN books b ON b.rowid = books_fts.rowid "
+    "WHERE books_fts MATCH ?1 AND b.status = 0 AND b.available_copies > 0 "
+    "ORDER BY bm25(books_fts, 1.0, 10.0, 5.0) LIMIT ?2";
+
+// Substring scans for files without the search index
+static const char* const BOOK_SCAN_SQL =
+    "SELECT isbn, title, author, genre, publication_year, total_copies, available_copies, status FROM books "
+    "WHERE instr(title, ?1) > 0 OR instr(author, ?1) > 0 OR instr(isbn, ?1) > 0 ORDER BY title, isbn LIMIT ?2";
+static const char* const BOOK_LIST_SCAN_SQL =
+    "SELECT isbn, title, author, publication_year, total_copies, available_copies, status FROM books "
+    "WHERE instr(title, ?1) > 0 OR instr(author, ?1) > 0 OR instr(isbn, ?1) > 0 ORDER BY title, isbn LIMIT ?2";
+static const char* const BOOK_LIST_AVAILABLE_SCAN_SQL =
+    "SELECT isbn, title, author, publication_year, total_copies, available_copies, status FROM books "
+    "WHERE (instr(title, ?1) > 0 OR instr(author, ?1) > 0 OR instr(isbn, ?1) > 0) "
+    "AND status = 0 AND available_copies > 0 ORDER BY title, isbn LIMIT ?2";
+
+template <typename Row>
+std::vector<Row> DatabaseManager::searchBookRows(const char* ftsSql, const char* scanSql, const std::string& query, int limit) {
+    ConnectionLease conn = readConnection();
+    std::vector<Row> books;
+
+    if (!fullTextSearch) {
+        CachedStatement stmt = conn->statements.acquire(scanSql);
+        if (!stmt) {
+            std::cerr << "SQLite prepare failed (searchBooks): " << sqlite3_errmsg(conn->db) << std::endl;
+            return books;
+        }
+        bindParams(stmt, query, limit);
+        readRows(stmt, books);
+        return books;
+    }
+
+    std::string match = toMatchQuery(query);
+    if (match.empty()) return books;
+
+    CachedStatement stmt = conn->statements.acquire(ftsSql);
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (searchBooks): " << sqlite3_errmsg(conn->db) << std::endl;
+        return books;
+    }
+    bindParams(stmt, match, limit);
+    if (readRows(stmt, books) != SQLITE_DONE) {
+        std::cerr << "SQLite step failed (searchBooks): " << sqlite3_errmsg(conn->db) << std::endl;
+    }
+    return books;
+}
+
+std::vector<Book> DatabaseManager::searchBooks(const std::string& query, int limit) {
+    QueryTimer timer(stats, DbMethod::SearchBooks);
+    std::vector<Book> books = searchBookRows<Book>(BOOK_SEARCH_SQL, BOOK_SCAN_SQL, query, limit);
+    timer.rows(books.size());
+    return books;
+}
+
+std::vector<BookListItem> DatabaseManager::searchBookList(const std::string& query, bool availableOnly, int limit) {
+    QueryTimer timer(stats, DbMethod::SearchBookList);
+    std::vector<BookListItem> books = availableOnly
+        ? searchBookRows<BookListItem>(BOOK_LIST_AVAILABLE_SEARCH_SQL, BOOK_LIST_AVAILABLE_SCAN_SQL, query, limit)
+        : searchBookRows<BookListItem>(BOOK_LIST_SEARCH_SQL, BOOK_LIST_SCAN_SQL, query, limit);
+    timer.rows(books.size());
     return books;
 }
 
 std::optional<Book> DatabaseManager::findBook(const std::string& isbn) {
+    QueryTimer timer(stats, DbMethod::FindBook);
+    ConnectionLease conn = readConnection();
     const char* sql = "SELECT isbn, title, author, genre, publication_year, total_copies, available_copies, status FROM books WHERE isbn = ? LIMIT 1";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "SQLite prepare failed (findBook): " << sqlite3_errmsg(db) << std::endl;
+    CachedStatement stmt = conn->statements.acquire(sql);
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (findBook): " << sqlite3_errmsg(conn->db) << std::endl;
         return std::nullopt;
     }
-    sqlite3_bind_text(stmt, 1, isbn.c_str(), -1, SQLITE_TRANSIENT);
+    bindParams(stmt, isbn);
     std::optional<Book> result;
     if (sqlite3_step(stmt) == SQLITE_ROW) {
-        const unsigned char* t0 = sqlite3_column_text(stmt, 0);
-        const unsigned char* t1 = sqlite3_column_text(stmt, 1);
-        const unsigned char* t2 = sqlite3_column_text(stmt, 2);
-        const unsigned char* t3 = sqlite3_column_text(stmt, 3);
-        std::string s_isbn = t0 ? reinterpret_cast<const char*>(t0) : std::string();
-        std::string title = t1 ? reinterpret_cast<const char*>(t1) : std::string();
-        std::string author = t2 ? reinterpret_cast<const char*>(t2) : std::string();
-        std::string genre = t3 ? reinterpret_cast<const char*>(t3) : std::string();
-        int pub = sqlite3_column_int(stmt, 4);
-        int total = sqlite3_column_int(stmt, 5);
-        int avail = sqlite3_column_int(stmt, 6);
-        int statusInt = sqlite3_column_int(stmt, 7);
-        result = Book(s_isbn, title, author, genre, pub, total, avail, static_cast<Book::Status>(statusInt));
-    }
-    sqlite3_finalize(stmt);
+        result = mapRow<Book>(stmt);
+        timer.rows(1);
+    }
     return result;
 }
 
 
 bool DatabaseManager::addMember(const Member& member) {
+    QueryTimer timer(stats, DbMethod::AddMember);
+    ConnectionLease conn = writeConnection();
     const char* sql = "INSERT INTO members (name, email, phone, member_type, max_books_allowed) VALUES (?, ?, ?, ?, ?)";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "SQLite prepare failed (addMember): " << sqlite3_errmsg(db) << std::endl;
+    CachedStatement stmt = conn->statements.acquire(sql);
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (addMember): " << sqlite3_errmsg(conn->db) << std::endl;
         return false;
     }
-    sqlite3_bind_text(stmt, 1, member.getName().c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 2, member.getEmail().c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 3, member.getPhone().c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_int(stmt, 4, static_cast<int>(member.getType()));
-    sqlite3_bind_int(stmt, 5, member.getMaxBooksAllowed());
+    bindParams(stmt, member.getName(), member.getEmail(), member.getPhone(), member.getType(), member.getMaxBooksAllowed());
     bool ok = sqlite3_step(stmt) == SQLITE_DONE;
-    if (!ok) std::cerr << "SQLite step failed (addMember): " << sqlite3_errmsg(db) << std::endl;
-    sqlite3_finalize(stmt);
+    if (!ok) std::cerr << "SQLite step failed (addMember): " << sqlite3_errmsg(conn->db) << std::endl;
+    if (ok) timer.rows(sqlite3_changes(conn->db));
     return ok;
 }
 
 bool DatabaseManager::updateMember(const Member& member) {
+    QueryTimer timer(stats, DbMethod::UpdateMember);
+    ConnectionLease conn = writeConnection();
     const char* sql = "UPDATE members SET name=?, email=?, phone=?, member_type=?, max_books_allowed=? WHERE id=?";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "SQLite prepare failed (updateMember): " << sqlite3_errmsg(db) << std::endl;
+    CachedStatement stmt = conn->statements.acquire(sql);
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (updateMember): " << sqlite3_errmsg(conn->db) << std::endl;
         return false;
     }
-    sqlite3_bind_text(stmt, 1, member.getName().c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 2, member.getEmail().c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 3, member.getPhone().c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_int(stmt, 4, static_cast<int>(member.getType()));
-    sqlite3_bind_int(stmt, 5, member.getMaxBooksAllowed());
-    sqlite3_bind_int(stmt, 6, member.getId());
+    bindParams(stmt, member.getName(), member.getEmail(), member.getPhone(), member.getType(),
+               member.getMaxBooksAllowed(), member.getId());
     bool ok = sqlite3_step(stmt) == SQLITE_DONE;
-    if (!ok) std::cerr << "SQLite step failed (updateMember): " << sqlite3_errmsg(db) << std::endl;
-    sqlite3_finalize(stmt);
+    if (!ok) std::cerr << "SQLite step failed (updateMember): " << sqlite3_errmsg(conn->db) << std::endl;
+    if (ok) timer.rows(sqlite3_changes(conn->db));
     return ok;
 }
 
 bool DatabaseManager::deleteMember(int id) {
+    QueryTimer timer(stats, DbMethod::DeleteMember);
+    ConnectionLease conn = writeConnection();
     const char* sql = "DELETE FROM members WHERE id = ?";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "SQLite prepare failed (deleteMember): " << sqlite3_errmsg(db) << std::endl;
+    CachedStatement stmt = conn->statements.acquire(sql);
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (deleteMember): " << sqlite3_errmsg(conn->db) << std::endl;
         return false;
     }
-    sqlite3_bind_int(stmt, 1, id);
+    bindParams(stmt, id);
     bool ok = sqlite3_step(stmt) == SQLITE_DONE;
-    if (!ok) std::cerr << "SQLite step failed (deleteMember): " << sqlite3_errmsg(db) << std::endl;
-    sqlite3_finalize(stmt);
+    if (!ok) std::cerr << "SQLite step failed (deleteMember): " << sqlite3_errmsg(conn->db) << std::endl;
+    if (ok) timer.rows(sqlite3_changes(conn->db));
     return ok;
 }
 
 std::vector<Member> DatabaseManager::getAllMembers() {
+    QueryTimer timer(stats, DbMethod::GetAllMembers);
     std::vector<Member> members;
+    for (Member& member : openMemberCursor()) {
+        members.push_back(std::move(member));
+    }
+    timer.rows(members.size());
+    return members;
+}
+
+RowCursor<Member> DatabaseManager::openMemberCursor() {
+    QueryTimer timer(stats, DbMethod::OpenMemberCursor);
+    ConnectionLease conn = readConnection();
     const char* sql = "SELECT id, name, email, phone, member_type, max_books_allowed FROM members";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "SQLite prepare failed (getAllMembers): " << sqlite3_errmsg(db) << std::endl;
+    CachedStatement stmt = conn->statements.acquire(sql);
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (openMemberCursor): " << sqlite3_errmsg(conn->db) << std::endl;
+    }
+    return RowCursor<Member>(std::move(conn), std::move(stmt));
+}
+
+bool DatabaseManager::forEachMember(const std::function<bool(const Member&)>& visitor) {
+    QueryTimer timer(stats, DbMethod::ForEachMember);
+    for (const Member& member : openMemberCursor()) {
+        if (!visitor(member)) return false;
+    }
+    return true;
+}
+
+static const char* const MEMBER_PAGE_SQL[2][2] = {
+    { "SELECT id, name, email, phone, member_type, max_books_allowed FROM members "
+      "ORDER BY id LIMIT ?3",
+      "SELECT id, name, email, phone, member_type, max_books_allowed FROM members "
+      "WHERE id > ?2 ORDER BY id LIMIT ?3" },
+    { "SELECT id, name, email, phone, member_type, max_books_allowed FROM members "
+      "ORDER BY name, id LIMIT ?3",
+      "SELECT id, name, email, phone, member_type, max_books_allowed FROM members "
+      "WHERE (name, id) > (?1, ?2) ORDER BY name, id LIMIT ?3" },
+};
+
+std::vector<Member> DatabaseManager::getMembersPage(const std::optional<MemberPageKey>& after, int limit, MemberSort sort) {
+    QueryTimer timer(stats, DbMethod::GetMembersPage);
+    ConnectionLease conn = readConnection();
+    std::vector<Member> members;
+    const char* sql = MEMBER_PAGE_SQL[static_cast<int>(sort)][after ? 1 : 0];
+    CachedStatement stmt = conn->statements.acquire(sql);
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (getMembersPage): " << sqlite3_errmsg(conn->db) << std::endl;
         return members;
     }
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        int id = sqlite3_column_int(stmt, 0);
-        const unsigned char* t1 = sqlite3_column_text(stmt, 1);
-        const unsigned char* t2 = sqlite3_column_text(stmt, 2);
-        const unsigned char* t3 = sqlite3_column_text(stmt, 3);
-        std::string name = t1 ? reinterpret_cast<const char*>(t1) : std::string();
-        std::string email = t2 ? reinterpret_cast<const char*>(t2) : std::string();
-        std::string phone = t3 ? reinterpret_cast<const char*>(t3) : std::string();
-        Member::Type type = static_cast<Member::Type>(sqlite3_column_int(stmt, 4));
-        int maxAllowed = sqlite3_column_int(stmt, 5);
-        members.emplace_back(id, name, email, phone, type, maxAllowed);
-    }
-    sqlite3_finalize(stmt);
+    if (after) bindParams(stmt, after->sortValue, after->id);
+    bindValue(stmt, 3, limit);
+    members.reserve(limit > 0 ? limit : 0);
+    readRows(stmt, members);
+    timer.rows(members.size());
+    return members;
+}
+
+MemberPageKey DatabaseManager::memberPageKey(const Member& member, MemberSort sort) {
+    return { sort == MemberSort::Name ? member.getName() : std::string(), member.getId() };
+}
+
+int DatabaseManager::countMembers() {
+    QueryTimer timer(stats, DbMethod::CountMembers);
+    ConnectionLease conn = readConnection();
+    CachedStatement stmt = conn->statements.acquire("SELECT COUNT(*) FROM members");
+    return stmt && sqlite3_step(stmt) == SQLITE_ROW ? readColumn<int>(stmt, 0) : 0;
+}
+
+std::vector<MemberListItem> DatabaseManager::getMemberList() {
+    QueryTimer timer(stats, DbMethod::GetMemberList);
+    ConnectionLease conn = readConnection();
+    std::vector<MemberListItem> members;
+    CachedStatement stmt = conn->statements.acquire("SELECT id, name, phone, max_books_allowed FROM members ORDER BY id");
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (getMemberList): " << sqlite3_errmsg(conn->db) << std::endl;
+        return members;
+    }
+    readRows(stmt, members);
+    timer.rows(members.size());
     return members;
 }
 
 std::optional<Member> DatabaseManager::findMember(int id) {
+    QueryTimer timer(stats, DbMethod::FindMember);
+    ConnectionLease conn = readConnection();
     const char* sql = "SELECT id, name, email, phone, member_type, max_books_allowed FROM members WHERE id = ? LIMIT 1";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "SQLite prepare failed (findMember): " << sqlite3_errmsg(db) << std::endl;
+    CachedStatement stmt = conn->statements.acquire(sql);
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (findMember): " << sqlite3_errmsg(conn->db) << std::endl;
         return std::nullopt;
     }
-    sqlite3_bind_int(stmt, 1, id);
+    bindParams(stmt, id);
     std::optional<Member> result;
     if (sqlite3_step(stmt) == SQLITE_ROW) {
-        int mid = sqlite3_column_int(stmt, 0);
-        const unsigned char* t1 = sqlite3_column_text(stmt, 1);
-        const unsigned char* t2 = sqlite3_column_text(stmt, 2);
-        const unsigned char* t3 = sqlite3_column_text(stmt, 3);
-        std::string name = t1 ? reinterpret_cast<const char*>(t1) : std::string();
-        std::string email = t2 ? reinterpret_cast<const char*>(t2) : std::string();
-        std::string phone = t3 ? reinterpret_cast<const char*>(t3) : std::string();
-        Member::Type type = static_cast<Member::Type>(sqlite3_column_int(stmt, 4));
-        int maxAllowed = sqlite3_column_int(stmt, 5);
-        result = Member(mid, name, email, phone, type, maxAllowed);
-    }
-    sqlite3_finalize(stmt);
+        result = mapRow<Member>(stmt);
+        timer.rows(1);
+    }
     return result;
 }
 
 
-bool DatabaseManager::addLoan(const Loan& loan) {
-    // Use transaction: insert loan and decrement book.available_copies
-    if (!executeSQL("BEGIN TRANSACTION;")) {
-        std::cerr << "Failed to begin transaction for addLoan" << std::endl;
-        return false;
+CheckoutResult DatabaseManager::checkout(const Loan& loan, int* loanId) {
+    QueryTimer timer(stats, DbMethod::Checkout);
+    ConnectionLease conn = writeConnection();
+    // Holds the write lock across the insert and, on a refusal, the query for its reason, so another
+    // desk cannot return a copy in between and turn NoCopiesAvailable into LimitReached
+    Transaction tx(conn->db);
+    if (!tx) {
+        std::cerr << "Failed to begin transaction (checkout)" << std::endl;
+        return CheckoutResult::Failed;
     }
 
-    // Check book exists and has available copies
-    auto bookOpt = findBook(loan.getBookISBN());
-    if (!bookOpt.has_value()) {
-        std::cerr << "Book not found when adding loan: " << loan.getBookISBN() << std::endl;
-        executeSQL("ROLLBACK;");
-        return false;
+    // Eligibility and the loan in one statement: the row is only inserted while a copy is free and
+    // the member is under their limit. The loans_counters_insert trigger takes the copy.
+    const char* insert_sql = R"(
+        INSERT INTO loans (book_isbn, member_id, loan_date, due_date, return_date, is_returned, fine_amount)
+        SELECT ?1, ?2, ?3, ?4, NULL, 0, 0.0
+        WHERE EXISTS (SELECT 1 FROM books WHERE isbn = ?1 AND available_copies > 0)
+          AND EXISTS (SELECT 1 FROM members WHERE id = ?2 AND active_loans < max_books_allowed)
+    )";
+    CachedStatement insert = conn->statements.acquire(insert_sql);
+    if (!insert) {
+        std::cerr << "SQLite prepare failed (checkout): " << sqlite3_errmsg(conn->db) << std::endl;
+        return CheckoutResult::Failed;
     }
-    Book book = bookOpt.value();
-    if (book.getAvailableCopies() <= 0) {
-        std::cerr << "No available copies for book when adding loan: " << loan.getBookISBN() << std::endl;
-        executeSQL("ROLLBACK;");
-        return false;
+    bindParams(insert, loan.getBookISBN(), loan.getMemberId(), loan.getLoanDate(), loan.getDueDate());
+    if (sqlite3_step(insert) != SQLITE_DONE) {
+        std::cerr << "SQLite step failed (checkout): " << sqlite3_errmsg(conn->db) << std::endl;
+        return CheckoutResult::Failed;
     }
+    insert.release();
 
-    const char* sql =
-        "INSERT INTO loans (book_isbn, member_id, loan_date, due_date, return_date, is_returned, fine_amount) "
-        "VALUES (?, ?, ?, ?, ?, ?, ?)";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "SQLite prepare failed (addLoan): " << sqlite3_errmsg(db) << std::endl;
-        executeSQL("ROLLBACK;");
-        return false;
+    if (sqlite3_changes(conn->db) == 0) {
+        // Only the refusal path pays for finding out why
+        const char* why_sql =
+            "SELECT (SELECT available_copies FROM books WHERE isbn = ?1), "
+            "(SELECT max_books_allowed FROM members WHERE id = ?2)";
+        CachedStatement why = conn->statements.acquire(why_sql);
+        if (!why) {
+            std::cerr << "SQLite prepare failed (checkout): " << sqlite3_errmsg(conn->db) << std::endl;
+            return CheckoutResult::Failed;
+        }
+        bindParams(why, loan.getBookISBN(), loan.getMemberId());
+        if (sqlite3_step(why) != SQLITE_ROW) return CheckoutResult::Failed;
+        auto [copies, limit] = readRow<std::optional<int>, std::optional<int>>(why);
+        if (!copies) return CheckoutResult::BookNotFound;
+        if (!limit) return CheckoutResult::MemberNotFound;
+        if (*copies <= 0) return CheckoutResult::NoCopiesAvailable;
+        return CheckoutResult::LimitReached;
     }
 
-    sqlite3_bind_text(stmt, 1, loan.getBookISBN().c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_int(stmt, 2, loan.getMemberId());
-    sqlite3_bind_int64(stmt, 3, timepoint_to_seconds(loan.getLoanDate()));
-    sqlite3_bind_int64(stmt, 4, timepoint_to_seconds(loan.getDueDate()));
-    if (loan.getIsReturned()) sqlite3_bind_int64(stmt, 5, timepoint_to_seconds(loan.getReturnDate()));
-    else sqlite3_bind_null(stmt, 5);
-    sqlite3_bind_int(stmt, 6, loan.getIsReturned() ? 1 : 0);
-    sqlite3_bind_double(stmt, 7, loan.getFineAmount());
-
-    bool ok = sqlite3_step(stmt) == SQLITE_DONE;
-    if (!ok) {
-        std::cerr << "SQLite step failed (addLoan): " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_finalize(stmt);
-        executeSQL("ROLLBACK;");
-        return false;
+    int id = static_cast<int>(sqlite3_last_insert_rowid(conn->db));
+    if (!tx.commit()) {
+        std::cerr << "Failed to commit checkout transaction" << std::endl;
+        return CheckoutResult::Failed;
     }
-    sqlite3_finalize(stmt);
+    if (loanId) *loanId = id;
+    timer.rows(1);
+    return CheckoutResult::Ok;
+}
 
-    // decrement available_copies and update book row
-    book.setAvailableCopies(book.getAvailableCopies() - 1);
-    if (book.getAvailableCopies() < 0) book.setAvailableCopies(0);
-    if (book.getAvailableCopies() == 0) book.setStatus(Book::Status::BORROWED);
-    else book.setStatus(Book::Status::AVAILABLE);
+std::vector<CheckoutResult> DatabaseManager::checkoutBatch(int memberId, const std::vector<std::string>& isbns, int days) {
+    QueryTimer timer(stats, DbMethod::CheckoutBatch);
+    std::vector<CheckoutResult> results;
+    results.reserve(isbns.size());
+    ConnectionLease conn = writeConnection();
+    Transaction tx(conn->db);
+    if (!tx) {
+        std::cerr << "Failed to begin transaction (checkoutBatch)" << std::endl;
+        results.assign(isbns.size(), CheckoutResult::Failed);
+        return results;
+    }
 
-    if (!updateBook(book)) {
-        std::cerr << "Failed to update book after adding loan" << std::endl;
-        executeSQL("ROLLBACK;");
-        return false;
+    // A refused checkout inserts nothing, so it never affects the others
+    for (const auto& isbn : isbns) {
+        results.push_back(checkout(Loan(0, isbn, memberId, days)));
     }
 
-    if (!executeSQL("COMMIT;")) {
-        std::cerr << "Failed to commit addLoan transaction" << std::endl;
-        executeSQL("ROLLBACK;");
-        return false;
+    if (!tx.commit()) {
+        std::cerr << "Failed to commit checkoutBatch transaction" << std::endl;
+        results.assign(isbns.size(), CheckoutResult::Failed);
     }
+    return results;
+}
 
-    return true;
+bool DatabaseManager::addLoan(const Loan& loan) {
+    QueryTimer timer(stats, DbMethod::AddLoan);
+    return checkout(loan) == CheckoutResult::Ok;
 }
 
 std::vector<Loan> DatabaseManager::getAllLoans() {
+    QueryTimer timer(stats, DbMethod::GetAllLoans);
     std::vector<Loan> loans;
-    const char* sql = "SELECT id, book_isbn, member_id, loan_date, due_date, return_date, is_returned, fine_amount FROM loans";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "SQLite prepare failed (getAllLoans): " << sqlite3_errmsg(db) << std::endl;
-        return loans;
+    for (Loan& loan : openLoanCursor()) {
+        loans.push_back(std::move(loan));
     }
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        int id = sqlite3_column_int(stmt, 0);
-        const unsigned char* t1 = sqlite3_column_text(stmt, 1);
-        std::string isbn = t1 ? reinterpret_cast<const char*>(t1) : std::string();
-        int memberId = sqlite3_column_int(stmt, 2);
-        std::int64_t loan_time = sqlite3_column_int64(stmt, 3);
-        std::int64_t due_time = sqlite3_column_int64(stmt, 4);
-        std::chrono::system_clock::time_point loanDate = seconds_to_timepoint(loan_time);
-        std::chrono::system_clock::time_point dueDate = seconds_to_timepoint(due_time);
-
-        std::chrono::system_clock::time_point returnDate{};
-        bool isReturned = sqlite3_column_int(stmt, 6) != 0;
-        if (sqlite3_column_type(stmt, 5) != SQLITE_NULL) {
-            std::int64_t ret_time = sqlite3_column_int64(stmt, 5);
-            returnDate = seconds_to_timepoint(ret_time);
+    timer.rows(loans.size());
+    return loans;
+}
+
+// Splits [MIN(rowid), MAX(rowid)] of `table` into ranges and reads them with `sql`, whose ?1 and ?2
+// bound the rowid. Threads pull ranges until none are left, so a dense range does not hold up the
+// others; the ranges are then moved into the result in rowid order.
+template <typename Row>
+std::vector<Row> DatabaseManager::loadRowidRanges(const char* table, const char* sql, int threads) {
+    std::vector<Row> rows;
+    ConnectionLease writer = writeConnection();
+
+    std::int64_t first = 0;
+    std::int64_t last = -1;
+    {
+        std::string bounds_sql = std::string("SELECT MIN(rowid), MAX(rowid) FROM ") + table;
+        CachedStatement bounds = writer->statements.acquire(bounds_sql.c_str());
+        if (!bounds) {
+            std::cerr << "SQLite prepare failed (loadRowidRanges): " << sqlite3_errmsg(writer->db) << std::endl;
+            return rows;
+        }
+        if (sqlite3_step(bounds) == SQLITE_ROW && sqlite3_column_type(bounds, 0) != SQLITE_NULL) {
+            std::tie(first, last) = readRow<std::int64_t, std::int64_t>(bounds);
         }
+    }
+    if (last < first) return rows;
 
-        double fine = sqlite3_column_double(stmt, 7);
-        loans.emplace_back(id, isbn, memberId, loanDate, dueDate, returnDate, isReturned, fine);
+    // One thread reads straight into the result. Other connections to an in-memory database would
+    // open empty databases of their own.
+    if (threads <= 0) threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    if (threads == 1 || dbPath.empty() || dbPath == ":memory:") {
+        CachedStatement stmt = writer->statements.acquire(sql);
+        if (!stmt) {
+            std::cerr << "SQLite prepare failed (loadRowidRanges): " << sqlite3_errmsg(writer->db) << std::endl;
+            return rows;
+        }
+        bindParams(stmt, first, last);
+        readRows(stmt, rows);
+        return rows;
     }
-    sqlite3_finalize(stmt);
+
+    const std::int64_t span = last - first + 1;
+    const int ranges = static_cast<int>(std::min<std::int64_t>(span, threads * 4));
+    std::vector<std::vector<Row>> parts(ranges);
+    std::atomic<int> next{0};
+    std::atomic<bool> failed{false};
+
+    auto readRanges = [&]() {
+        Connection conn;
+        if (!conn.open(dbPath, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, options)) {
+            failed = true;
+            return;
+        }
+        if (slowQueries.enabled()) slowQueries.attach(conn.db);
+        CachedStatement stmt = conn.statements.acquire(sql);
+        if (!stmt) {
+            std::cerr << "SQLite prepare failed (loadRowidRanges): " << sqlite3_errmsg(conn.db) << std::endl;
+            failed = true;
+        }
+        for (int i = next++; stmt && i < ranges && !failed; i = next++) {
+            std::int64_t from = first + span * i / ranges;
+            std::int64_t to = first + span * (i + 1) / ranges - 1;
+            bindParams(stmt, from, to);
+            if (readRows(stmt, parts[i]) != SQLITE_DONE) {
+                std::cerr << "SQLite step failed (loadRowidRanges): " << sqlite3_errmsg(conn.db) << std::endl;
+                failed = true;
+            }
+            sqlite3_reset(stmt);
+        }
+        stmt.release();
+        conn.close();
+    };
+
+    std::vector<std::thread> helpers;
+    for (int t = 1; t < threads; ++t) helpers.emplace_back(readRanges);
+    readRanges();
+    for (auto& helper : helpers) helper.join();
+    if (failed) return rows;
+
+    std::size_t total = 0;
+    for (const auto& part : parts) total += part.size();
+    rows.reserve(total);
+    for (auto& part : parts) {
+        std::move(part.begin(), part.end(), std::back_inserter(rows));
+    }
+    return rows;
+}
+
+std::vector<Loan> DatabaseManager::getAllLoansParallel(int threads) {
+    QueryTimer timer(stats, DbMethod::GetAllLoansParallel);
+    std::vector<Loan> loans = loadRowidRanges<Loan>("loans",
+        "SELECT id, book_isbn, member_id, loan_date, due_date, return_date, is_returned, fine_amount FROM loans "
+        "WHERE rowid BETWEEN ?1 AND ?2",
+        threads);
+    timer.rows(loans.size());
     return loans;
 }
 
-std::vector<Loan> DatabaseManager::getActiveLoans() {
+RowCursor<Loan> DatabaseManager::openLoanCursor() {
+    QueryTimer timer(stats, DbMethod::OpenLoanCursor);
+    ConnectionLease conn = readConnection();
+    const char* sql = "SELECT id, book_isbn, member_id, loan_date, due_date, return_date, is_returned, fine_amount FROM loans";
+    CachedStatement stmt = conn->statements.acquire(sql);
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (openLoanCursor): " << sqlite3_errmsg(conn->db) << std::endl;
+    }
+    return RowCursor<Loan>(std::move(conn), std::move(stmt));
+}
+
+bool DatabaseManager::forEachLoan(const std::function<bool(const Loan&)>& visitor) {
+    QueryTimer timer(stats, DbMethod::ForEachLoan);
+    for (const Loan& loan : openLoanCursor()) {
+        if (!visitor(loan)) return false;
+    }
+    return true;
+}
+
+static const char* const LOAN_PAGE_SQL[2][2] = {
+    { "SELECT id, book_isbn, member_id, loan_date, due_date, return_date, is_returned, fine_amount FROM loans "
+      "ORDER BY id LIMIT ?3",
+      "SELECT id, book_isbn, member_id, loan_date, due_date, return_date, is_returned, fine_amount FROM loans "
+      "WHERE id > ?2 ORDER BY id LIMIT ?3" },
+    { "SELECT id, book_isbn, member_id, loan_date, due_date, return_date, is_returned, fine_amount FROM loans "
+      "ORDER BY due_date, id LIMIT ?3",
+      "SELECT id, book_isbn, member_id, loan_date, due_date, return_date, is_returned, fine_amount FROM loans "
+      "WHERE (due_date, id) > (?1, ?2) ORDER BY due_date, id LIMIT ?3" },
+};
+
+std::vector<Loan> DatabaseManager::getLoansPage(const std::optional<LoanPageKey>& after, int limit, LoanSort sort) {
+    QueryTimer timer(stats, DbMethod::GetLoansPage);
+    ConnectionLease conn = readConnection();
     std::vector<Loan> loans;
-    const char* sql = "SELECT id, book_isbn, member_id, loan_date, due_date FROM loans WHERE is_returned = 0";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "SQLite prepare failed (getActiveLoans): " << sqlite3_errmsg(db) << std::endl;
+    const char* sql = LOAN_PAGE_SQL[static_cast<int>(sort)][after ? 1 : 0];
+    CachedStatement stmt = conn->statements.acquire(sql);
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (getLoansPage): " << sqlite3_errmsg(conn->db) << std::endl;
         return loans;
     }
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        int id = sqlite3_column_int(stmt, 0);
-        const unsigned char* t1 = sqlite3_column_text(stmt, 1);
-        std::string isbn = t1 ? reinterpret_cast<const char*>(t1) : std::string();
-        int memberId = sqlite3_column_int(stmt, 2);
-        std::int64_t loan_time = sqlite3_column_int64(stmt, 3);
-        std::int64_t due_time = sqlite3_column_int64(stmt, 4);
-        std::chrono::system_clock::time_point loanDate = seconds_to_timepoint(loan_time);
-        std::chrono::system_clock::time_point dueDate = seconds_to_timepoint(due_time);
-        loans.emplace_back(id, isbn, memberId, loanDate, dueDate, std::chrono::system_clock::time_point{}, false, 0.0);
-    }
-    sqlite3_finalize(stmt);
+    if (after) bindParams(stmt, after->sortValue, after->id);
+    bindValue(stmt, 3, limit);
+    loans.reserve(limit > 0 ? limit : 0);
+    readRows(stmt, loans);
+    timer.rows(loans.size());
+    return loans;
+}
+
+// Same pages as LOAN_PAGE_SQL, with the book title and member name looked up by primary key
+static const char* const LOAN_VIEW_PAGE_SQL[2][2] = {
+    { "SELECT l.id, l.book_isbn, l.member_id, l.loan_date, l.due_date, l.return_date, l.is_returned, l.fine_amount, b.title, m.name "
+      "FROM loans l LEFT JOIN books b ON b.isbn = l.book_isbn LEFT JOIN members m ON m.id = l.member_id "
+      "ORDER BY l.id LIMIT ?3",
+      "SELECT l.id, l.book_isbn, l.member_id, l.loan_date, l.due_date, l.return_date, l.is_returned, l.fine_amount, b.title, m.name "
+      "FROM loans l LEFT JOIN books b ON b.isbn = l.book_isbn LEFT JOIN members m ON m.id = l.member_id "
+      "WHERE l.id > ?2 ORDER BY l.id LIMIT ?3" },
+    { "SELECT l.id, l.book_isbn, l.member_id, l.loan_date, l.due_date, l.return_date, l.is_returned, l.fine_amount, b.title, m.name "
+      "FROM loans l LEFT JOIN books b ON b.isbn = l.book_isbn LEFT JOIN members m ON m.id = l.member_id "
+      "ORDER BY l.due_date, l.id LIMIT ?3",
+      "SELECT l.id, l.book_isbn, l.member_id, l.loan_date, l.due_date, l.return_date, l.is_returned, l.fine_amount, b.title, m.name "
+      "FROM loans l LEFT JOIN books b ON b.isbn = l.book_isbn LEFT JOIN members m ON m.id = l.member_id "
+      "WHERE (l.due_date, l.id) > (?1, ?2) ORDER BY l.due_date, l.id LIMIT ?3" },
+};
+
+std::vector<LoanView> DatabaseManager::getLoanViewsPage(const std::optional<LoanPageKey>& after, int limit, LoanSort sort) {
+    QueryTimer timer(stats, DbMethod::GetLoanViewsPage);
+    ConnectionLease conn = readConnection();
+    std::vector<LoanView> views;
+    const char* sql = LOAN_VIEW_PAGE_SQL[static_cast<int>(sort)][after ? 1 : 0];
+    CachedStatement stmt = conn->statements.acquire(sql);
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (getLoanViewsPage): " << sqlite3_errmsg(conn->db) << std::endl;
+        return views;
+    }
+    if (after) bindParams(stmt, after->sortValue, after->id);
+    bindValue(stmt, 3, limit);
+    views.reserve(limit > 0 ? limit : 0);
+    readRows(stmt, views);
+    timer.rows(views.size());
+    return views;
+}
+
+LoanPageKey DatabaseManager::loanPageKey(const Loan& loan, LoanSort sort) {
+    return { sort == LoanSort::DueDate ? timepoint_to_seconds(loan.getDueDate()) : 0, loan.getId() };
+}
+
+int DatabaseManager::countLoans() {
+    QueryTimer timer(stats, DbMethod::CountLoans);
+    ConnectionLease conn = readConnection();
+    CachedStatement stmt = conn->statements.acquire("SELECT COUNT(*) FROM loans");
+    return stmt && sqlite3_step(stmt) == SQLITE_ROW ? readColumn<int>(stmt, 0) : 0;
+}
+
+// These read only idx_loans_active, never the returned history. The return columns of an active loan
+// are known, so they are selected as constants and the rows still map as whole loans.
+static const char* const ACTIVE_LOANS_SQL =
+    "SELECT id, book_isbn, member_id, loan_date, due_date, NULL, 0, 0.0 FROM loans WHERE is_returned = 0 ORDER BY due_date";
+static const char* const OVERDUE_LOANS_SQL =
+    "SELECT id, book_isbn, member_id, loan_date, due_date, NULL, 0, 0.0 FROM loans WHERE is_returned = 0 AND due_date < ?1 ORDER BY due_date";
+static const char* const ACTIVE_LOAN_VIEWS_SQL =
+    "SELECT l.id, l.book_isbn, l.member_id, l.loan_date, l.due_date, NULL, 0, 0.0, b.title, m.name "
+    "FROM loans l LEFT JOIN books b ON b.isbn = l.book_isbn LEFT JOIN members m ON m.id = l.member_id "
+    "WHERE l.is_returned = 0 ORDER BY l.due_date";
+static const char* const MEMBER_ACTIVE_LOANS_SQL =
+    "SELECT COUNT(*) FROM loans WHERE member_id = ?1 AND is_returned = 0";
+
+// Aggregates over the active-loan partial indexes; ?1 is the current time for the overdue split
+static const char* const MEMBER_LOAN_COUNTS_SQL =
+    "SELECT COUNT(*), COALESCE(SUM(due_date < ?1), 0) FROM loans WHERE member_id = ?2 AND is_returned = 0";
+static const char* const ALL_MEMBER_LOAN_COUNTS_SQL =
+    "SELECT member_id, COUNT(*), SUM(due_date < ?1) FROM loans WHERE is_returned = 0 GROUP BY member_id";
+static const char* const BOOK_COPIES_OUT_SQL =
+    "SELECT COUNT(*) FROM loans WHERE book_isbn = ?1 AND is_returned = 0";
+static const char* const ACTIVE_LOAN_TOTALS_SQL =
+    "SELECT COUNT(*), COALESCE(SUM(due_date < ?1), 0) FROM loans WHERE is_returned = 0";
+
+std::vector<Loan> DatabaseManager::getActiveLoans() {
+    QueryTimer timer(stats, DbMethod::GetActiveLoans);
+    ConnectionLease conn = readConnection();
+    CachedStatement stmt = conn->statements.acquire(ACTIVE_LOANS_SQL);
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (getActiveLoans): " << sqlite3_errmsg(conn->db) << std::endl;
+        return {};
+    }
+    std::vector<Loan> loans;
+    readRows(stmt, loans);
+    timer.rows(loans.size());
+    return loans;
+}
+
+std::vector<LoanView> DatabaseManager::getActiveLoanViews() {
+    QueryTimer timer(stats, DbMethod::GetActiveLoanViews);
+    ConnectionLease conn = readConnection();
+    std::vector<LoanView> views;
+    CachedStatement stmt = conn->statements.acquire(ACTIVE_LOAN_VIEWS_SQL);
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (getActiveLoanViews): " << sqlite3_errmsg(conn->db) << std::endl;
+        return views;
+    }
+    readRows(stmt, views);
+    timer.rows(views.size());
+    return views;
+}
+
+std::vector<Loan> DatabaseManager::getOverdueLoans() {
+    QueryTimer timer(stats, DbMethod::GetOverdueLoans);
+    ConnectionLease conn = readConnection();
+    CachedStatement stmt = conn->statements.acquire(OVERDUE_LOANS_SQL);
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (getOverdueLoans): " << sqlite3_errmsg(conn->db) << std::endl;
+        return {};
+    }
+    bindParams(stmt, std::chrono::system_clock::now());
+    std::vector<Loan> loans;
+    readRows(stmt, loans);
+    timer.rows(loans.size());
     return loans;
 }
 
+int DatabaseManager::countActiveLoans(int memberId) {
+    QueryTimer timer(stats, DbMethod::CountActiveLoans);
+    ConnectionLease conn = readConnection();
+    CachedStatement stmt = conn->statements.acquire(MEMBER_ACTIVE_LOANS_SQL);
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (countActiveLoans): " << sqlite3_errmsg(conn->db) << std::endl;
+        return 0;
+    }
+    bindParams(stmt, memberId);
+    return sqlite3_step(stmt) == SQLITE_ROW ? readColumn<int>(stmt, 0) : 0;
+}
+
+MemberLoanCounts DatabaseManager::getMemberLoanCounts(int memberId) {
+    QueryTimer timer(stats, DbMethod::GetMemberLoanCounts);
+    MemberLoanCounts counts;
+    counts.memberId = memberId;
+    ConnectionLease conn = readConnection();
+    CachedStatement stmt = conn->statements.acquire(MEMBER_LOAN_COUNTS_SQL);
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (getMemberLoanCounts): " << sqlite3_errmsg(conn->db) << std::endl;
+        return counts;
+    }
+    bindParams(stmt, std::chrono::system_clock::now(), memberId);
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        std::tie(counts.active, counts.overdue) = readRow<int, int>(stmt);
+    }
+    return counts;
+}
+
+std::vector<MemberLoanCounts> DatabaseManager::getMemberLoanCounts() {
+    QueryTimer timer(stats, DbMethod::GetAllMemberLoanCounts);
+    std::vector<MemberLoanCounts> counts;
+    ConnectionLease conn = readConnection();
+    CachedStatement stmt = conn->statements.acquire(ALL_MEMBER_LOAN_COUNTS_SQL);
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (getMemberLoanCounts): " << sqlite3_errmsg(conn->db) << std::endl;
+        return counts;
+    }
+    bindParams(stmt, std::chrono::system_clock::now());
+    readRows(stmt, counts);
+    timer.rows(counts.size());
+    return counts;
+}
+
+int DatabaseManager::countCopiesOut(const std::string& isbn) {
+    QueryTimer timer(stats, DbMethod::CountCopiesOut);
+    ConnectionLease conn = readConnection();
+    CachedStatement stmt = conn->statements.acquire(BOOK_COPIES_OUT_SQL);
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (countCopiesOut): " << sqlite3_errmsg(conn->db) << std::endl;
+        return 0;
+    }
+    bindParams(stmt, isbn);
+    return sqlite3_step(stmt) == SQLITE_ROW ? readColumn<int>(stmt, 0) : 0;
+}
+
+// One pass over members, joined to the per-member loan counts rather than to every loan row
+std::vector<MemberTypeTotals> DatabaseManager::getMemberTypeTotals() {
+    QueryTimer timer(stats, DbMethod::GetMemberTypeTotals);
+    std::vector<MemberTypeTotals> totals;
+    ConnectionLease conn = readConnection();
+    const char* sql = R"(
+        SELECT m.member_type, COUNT(*), COALESCE(SUM(c.active), 0), COALESCE(SUM(c.overdue), 0)
+        FROM members m
+        LEFT JOIN (SELECT member_id, COUNT(*) AS active, SUM(due_date < ?1) AS overdue
+                   FROM loans WHERE is_returned = 0 GROUP BY member_id) c ON c.member_id = m.id
+        GROUP BY m.member_type ORDER BY m.member_type
+    )";
+    CachedStatement stmt = conn->statements.acquire(sql);
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (getMemberTypeTotals): " << sqlite3_errmsg(conn->db) << std::endl;
+        return totals;
+    }
+    bindParams(stmt, std::chrono::system_clock::now());
+    readRows(stmt, totals);
+    timer.rows(totals.size());
+    return totals;
+}
+
+LibrarySummary DatabaseManager::getLibrarySummary() {
+    QueryTimer timer(stats, DbMethod::GetLibrarySummary);
+    LibrarySummary summary;
+    ConnectionLease conn = readConnection();
+    {
+        const char* sql =
+            "SELECT COUNT(*), COALESCE(SUM(total_copies), 0), COALESCE(SUM(available_copies), 0), "
+            "COALESCE(SUM(available_copies <= 0), 0) FROM books";
+        CachedStatement stmt = conn->statements.acquire(sql);
+        if (!stmt) {
+            std::cerr << "SQLite prepare failed (getLibrarySummary): " << sqlite3_errmsg(conn->db) << std::endl;
+            return summary;
+        }
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            std::tie(summary.titles, summary.totalCopies, summary.availableCopies, summary.unavailableTitles) =
+                readRow<int, int, int, int>(stmt);
+        }
+    }
+
+    CachedStatement stmt = conn->statements.acquire(ACTIVE_LOAN_TOTALS_SQL);
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (getLibrarySummary): " << sqlite3_errmsg(conn->db) << std::endl;
+        return summary;
+    }
+    bindParams(stmt, std::chrono::system_clock::now());
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        std::tie(summary.activeLoans, summary.overdueLoans) = readRow<int, int>(stmt);
+    }
+    return summary;
+}
+
+// Copy and member counters follow through the loans_counters_update trigger
 bool DatabaseManager::updateLoan(const Loan& loan) {
-    // Use transaction: update loan, and if transitioning to returned increment book.available_copies
-    if (!executeSQL("BEGIN TRANSACTION;")) {
-        std::cerr << "Failed to begin transaction (updateLoan)" << std::endl;
+    QueryTimer timer(stats, DbMethod::UpdateLoan);
+    ConnectionLease conn = writeConnection();
+    const char* sql = "UPDATE loans SET return_date = ?, is_returned = ?, fine_amount = ? WHERE id = ?";
+    CachedStatement stmt = conn->statements.acquire(sql);
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (updateLoan): " << sqlite3_errmsg(conn->db) << std::endl;
         return false;
     }
 
-    // Find current loan state
-    const char* sel_sql = "SELECT is_returned, book_isbn FROM loans WHERE id = ? LIMIT 1";
-    sqlite3_stmt* sel_stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sel_sql, -1, &sel_stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "SQLite prepare failed (updateLoan select): " << sqlite3_errmsg(db) << std::endl;
-        executeSQL("ROLLBACK;");
+    std::optional<SqlTime> returnDate;
+    if (loan.getIsReturned()) returnDate = loan.getReturnDate();
+    bindParams(stmt, returnDate, loan.getIsReturned(), loan.getFineAmount(), loan.getId());
+
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+        std::cerr << "SQLite step failed (updateLoan): " << sqlite3_errmsg(conn->db) << std::endl;
         return false;
     }
-    sqlite3_bind_int(sel_stmt, 1, loan.getId());
-    if (sqlite3_step(sel_stmt) != SQLITE_ROW) {
+    if (sqlite3_changes(conn->db) == 0) {
         std::cerr << "Loan not found for updateLoan id=" << loan.getId() << std::endl;
-        sqlite3_finalize(sel_stmt);
-        executeSQL("ROLLBACK;");
         return false;
     }
-    int old_is_returned = sqlite3_column_int(sel_stmt, 0);
-    const unsigned char* t_isbn = sqlite3_column_text(sel_stmt, 1);
-    std::string isbn = t_isbn ? reinterpret_cast<const char*>(t_isbn) : std::string();
-    sqlite3_finalize(sel_stmt);
-
-    // Update loan row
-    const char* upd_sql = "UPDATE loans SET return_date = ?, is_returned = ?, fine_amount = ? WHERE id = ?";
-    sqlite3_stmt* upd_stmt = nullptr;
-    if (sqlite3_prepare_v2(db, upd_sql, -1, &upd_stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "SQLite prepare failed (updateLoan update): " << sqlite3_errmsg(db) << std::endl;
-        executeSQL("ROLLBACK;");
+    timer.rows(1);
+    return true;
+}
+
+bool DatabaseManager::returnBatch(const std::vector<int>& loanIds, std::chrono::system_clock::time_point returnTime, int* returned) {
+    QueryTimer timer(stats, DbMethod::ReturnBatch);
+    if (returned) *returned = 0;
+    if (loanIds.empty()) return true;
+
+    // The ids travel as one JSON array, so the statement stays prepared whatever the batch size
+    std::string ids = "[";
+    for (size_t i = 0; i < loanIds.size(); ++i) {
+        if (i > 0) ids += ',';
+        ids += std::to_string(loanIds[i]);
+    }
+    ids += ']';
+
+    ConnectionLease conn = writeConnection();
+
+    // Same rule as Loan::calculateFine: every started overdue day (counted in whole hours) is charged.
+    // The loans_counters_update trigger gives the copies back and moves the fines to the members.
+    const char* loans_sql = R"(
+        UPDATE loans
+        SET is_returned = 1,
+            return_date = ?2,
+            fine_amount = CASE WHEN ?2 > due_date THEN ((?2 - due_date) / 3600 + 23) / 24 * ?3 ELSE 0.0 END
+        WHERE id IN (SELECT value FROM json_each(?1)) AND is_returned = 0
+    )";
+    CachedStatement checkin = conn->statements.acquire(loans_sql);
+    if (!checkin) {
+        std::cerr << "SQLite prepare failed (returnBatch): " << sqlite3_errmsg(conn->db) << std::endl;
+        return false;
+    }
+    bindParams(checkin, ids, returnTime, Loan::FINE_PER_DAY);
+    if (sqlite3_step(checkin) != SQLITE_DONE) {
+        std::cerr << "SQLite step failed (returnBatch): " << sqlite3_errmsg(conn->db) << std::endl;
+        return false;
+    }
+    checkin.release();
+    timer.rows(sqlite3_changes(conn->db));
+    if (returned) *returned = sqlite3_changes(conn->db);
+    return true;
+}
+
+std::vector<bool> DatabaseManager::groupCommit(const std::vector<std::function<bool(DatabaseManager&)>>& writes) {
+    QueryTimer timer(stats, DbMethod::GroupCommit);
+    std::vector<bool> kept(writes.size(), false);
+    ConnectionLease conn = writeConnection();
+    Transaction tx(conn->db);
+    if (!tx) {
+        std::cerr << "Failed to begin transaction (groupCommit)" << std::endl;
+        return kept;
+    }
+
+    for (size_t i = 0; i < writes.size(); ++i) {
+        {
+            Transaction step(conn->db);
+            if (step && writes[i](*this)) step.commit();
+        }
+        if (sqlite3_get_autocommit(conn->db) != 0) {
+            // SQLite gave up the whole transaction (I/O error, full disk): the writes so far are gone,
+            // the rest run with a commit each
+            std::cerr << "groupCommit transaction rolled back after write " << i + 1 << " of " << writes.size() << std::endl;
+            for (size_t j = i + 1; j < writes.size(); ++j) {
+                writes[j](*this);
+                kept[j] = true;
+            }
+            return kept;
+        }
+    }
+
+    if (!tx.commit()) {
+        std::cerr << "Failed to commit groupCommit transaction" << std::endl;
+        return kept;
+    }
+    kept.assign(writes.size(), true);
+    timer.rows(writes.size());
+    return kept;
+}
+
+std::vector<MemberFineReport> DatabaseManager::getFineReport(int limit) {
+    QueryTimer timer(stats, DbMethod::GetFineReport);
+    std::vector<MemberFineReport> rows;
+    ConnectionLease conn = readConnection();
+    const char* sql = R"(
+        SELECT m.id, m.name, COUNT(*), SUM(l.is_returned = 1 AND l.return_date > l.due_date), SUM(l.fine_amount)
+        FROM loans l JOIN members m ON m.id = l.member_id
+        GROUP BY m.id
+        ORDER BY SUM(l.fine_amount) DESC, m.id
+        LIMIT ?1
+    )";
+    CachedStatement stmt = conn->statements.acquire(sql);
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (getFineReport): " << sqlite3_errmsg(conn->db) << std::endl;
+        return rows;
+    }
+    bindParams(stmt, limit);
+    readRows(stmt, rows);
+    timer.rows(rows.size());
+    return rows;
+}
+
+std::vector<CirculationMonth> DatabaseManager::getCirculationReport(int months) {
+    QueryTimer timer(stats, DbMethod::GetCirculationReport);
+    std::vector<CirculationMonth> rows;
+    ConnectionLease conn = readConnection();
+    const char* sql = R"(
+        SELECT strftime('%Y-%m', loan_date, 'unixepoch', 'localtime') AS month, COUNT(*), SUM(is_returned),
+               SUM(is_returned = 1 AND return_date > due_date), SUM(fine_amount)
+        FROM loans
+        GROUP BY month
+        ORDER BY month DESC
+        LIMIT ?1
+    )";
+    CachedStatement stmt = conn->statements.acquire(sql);
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (getCirculationReport): " << sqlite3_errmsg(conn->db) << std::endl;
+        return rows;
+    }
+    bindParams(stmt, months);
+    readRows(stmt, rows);
+    timer.rows(rows.size());
+    return rows;
+}
+
+// What the loan triggers should have produced, computed set-wise from loans
+static const char* const EXPECTED_BOOK_COUNTERS_SQL = R"(
+    SELECT b.isbn, b.available_copies, MAX(0, b.total_copies - COALESCE(a.active, 0)) AS expected
+    FROM books b
+    LEFT JOIN (SELECT book_isbn, COUNT(*) AS active FROM loans WHERE is_returned = 0 GROUP BY book_isbn) a
+        ON a.book_isbn = b.isbn
+)";
+static const char* const EXPECTED_MEMBER_COUNTERS_SQL = R"(
+    SELECT m.id, m.active_loans, m.outstanding_fines,
+           COALESCE(c.active, 0) AS expected_active, COALESCE(c.fines, 0.0) AS expected_fines
+    FROM members m
+    LEFT JOIN (SELECT member_id, SUM(is_returned = 0) AS active, SUM(fine_amount) AS fines
+               FROM loans GROUP BY member_id) c
+        ON c.member_id = m.id
+)";
+
+// Indexes and triggers BulkImporter dropped and has not rebuilt yet, as (name, CREATE statement).
+std::vector<std::pair<std::string, std::string>> DatabaseManager::droppedByImport() {
+    std::vector<std::pair<std::string, std::string>> objects;
+    ConnectionLease conn = readConnection();
+    CachedStatement exists = conn->statements.acquire("SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'import_dropped'");
+    if (!exists || sqlite3_step(exists) != SQLITE_ROW) return objects;
+
+    CachedStatement stmt = conn->statements.acquire("SELECT name, sql FROM import_dropped ORDER BY name");
+    if (!stmt) {
+        std::cerr << "SQLite prepare failed (droppedByImport): " << sqlite3_errmsg(conn->db) << std::endl;
+        return objects;
+    }
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        auto [name, sql] = readRow<std::string, std::string>(stmt);
+        objects.emplace_back(std::move(name), std::move(sql));
+    }
+    return objects;
+}
+
+// Re-creates what an unfinished import dropped, in one transaction. The search index is rebuilt
+// when its triggers were among them, since rows imported without them are missing from it.
+bool DatabaseManager::restoreDroppedByImport() {
+    auto objects = droppedByImport();
+    if (objects.empty()) return true;
+
+    ConnectionLease conn = writeConnection();
+    Transaction tx(conn->db);
+    if (!tx) {
+        std::cerr << "Failed to begin transaction (restoreDroppedByImport)" << std::endl;
+        return false;
+    }
+    bool searchTriggers = false;
+    for (const auto& [name, sql] : objects) {
+        if (!executeSQL(sql + ";")) return false;
+        searchTriggers = searchTriggers || name.rfind("books_fts_", 0) == 0;
+    }
+    if (!executeSQL("DELETE FROM import_dropped;")) return false;
+    if (searchTriggers && fullTextSearch && !executeSQL("INSERT INTO books_fts (books_fts) VALUES ('rebuild');")) {
+        return false;
+    }
+    if (!tx.commit()) {
+        std::cerr << "Failed to commit restoreDroppedByImport transaction" << std::endl;
         return false;
     }
+    std::cout << "Restored " << objects.size() << " index(es) and trigger(s) left out by an unfinished import" << std::endl;
+    return true;
+}
+
+bool DatabaseManager::reconcileCounters(CounterDrift& drift) {
+    QueryTimer timer(stats, DbMethod::ReconcileCounters);
+    const size_t MAX_DETAILS = 20;
+    drift = CounterDrift();
+    if (!restoreDroppedByImport()) return false;
 
-    if (loan.getIsReturned()) {
-        sqlite3_bind_int64(upd_stmt, 1, timepoint_to_seconds(loan.getReturnDate()));
-    } else {
-        sqlite3_bind_null(upd_stmt, 1);
+    ConnectionLease conn = writeConnection();
+    Transaction tx(conn->db);
+    if (!tx) {
+        std::cerr << "Failed to begin transaction (reconcileCounters)" << std::endl;
+        return false;
     }
-    sqlite3_bind_int(upd_stmt, 2, loan.getIsReturned() ? 1 : 0);
-    sqlite3_bind_double(upd_stmt, 3, loan.getFineAmount());
-    sqlite3_bind_int(upd_stmt, 4, loan.getId());
 
-    if (sqlite3_step(upd_stmt) != SQLITE_DONE) {
-        std::cerr << "SQLite step failed (updateLoan update): " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_finalize(upd_stmt);
-        executeSQL("ROLLBACK;");
+    std::string books_sql = std::string("SELECT isbn, available_copies, expected FROM (") + EXPECTED_BOOK_COUNTERS_SQL +
+                            ") WHERE available_copies IS NOT expected";
+    CachedStatement books = conn->statements.acquire(books_sql.c_str());
+    if (!books) {
+        std::cerr << "SQLite prepare failed (reconcileCounters): " << sqlite3_errmsg(conn->db) << std::endl;
         return false;
     }
-    sqlite3_finalize(upd_stmt);
+    while (sqlite3_step(books) == SQLITE_ROW) {
+        ++drift.books;
+        if (drift.details.size() < MAX_DETAILS) {
+            auto [isbn, stored, expected] = readRow<std::string, int, int>(books);
+            drift.details.push_back("book " + isbn + ": available_copies " + std::to_string(stored) +
+                                    ", expected " + std::to_string(expected));
+        }
+    }
+    books.release();
 
-    // If transitioning from not returned -> returned, increment book.available_copies
-    if (old_is_returned == 0 && loan.getIsReturned()) {
-        auto bookOpt = findBook(isbn);
-        if (!bookOpt.has_value()) {
-            std::cerr << "Book not found while updating loan: " << isbn << std::endl;
-            executeSQL("ROLLBACK;");
-            return false;
+    // Fines are sums of REAL amounts, so allow for rounding in the comparison
+    std::string members_sql = std::string("SELECT id, active_loans, outstanding_fines, expected_active, expected_fines FROM (") +
+                              EXPECTED_MEMBER_COUNTERS_SQL +
+                              ") WHERE active_loans IS NOT expected_active OR ABS(outstanding_fines - expected_fines) > 0.005";
+    CachedStatement members = conn->statements.acquire(members_sql.c_str());
+    if (!members) {
+        std::cerr << "SQLite prepare failed (reconcileCounters): " << sqlite3_errmsg(conn->db) << std::endl;
+        return false;
+    }
+    while (sqlite3_step(members) == SQLITE_ROW) {
+        ++drift.members;
+        if (drift.details.size() < MAX_DETAILS) {
+            auto [id, active, fines, expectedActive, expectedFines] = readRow<int, int, double, int, double>(members);
+            drift.details.push_back("member " + std::to_string(id) +
+                                    ": active_loans " + std::to_string(active) + ", expected " + std::to_string(expectedActive) +
+                                    "; outstanding_fines " + std::to_string(fines) + ", expected " + std::to_string(expectedFines));
         }
-        Book book = bookOpt.value();
-        book.setAvailableCopies(book.getAvailableCopies() + 1);
-        if (book.getAvailableCopies() > 0) book.setStatus(Book::Status::AVAILABLE);
-        if (!updateBook(book)) {
-            std::cerr << "Failed to update book while updating loan" << std::endl;
-            executeSQL("ROLLBACK;");
-            return false;
+    }
+    members.release();
+
+    if (drift.empty()) return true;
+
+    std::string fix_books = std::string(R"(
+        UPDATE books
+        SET available_copies = fixed.expected,
+            status = CASE WHEN fixed.expected > 0 THEN 0 ELSE 1 END
+        FROM ()") + EXPECTED_BOOK_COUNTERS_SQL + R"() AS fixed
+        WHERE books.isbn = fixed.isbn AND books.available_copies IS NOT fixed.expected
+    )";
+    std::string fix_members = std::string(R"(
+        UPDATE members
+        SET active_loans = fixed.expected_active, outstanding_fines = fixed.expected_fines
+        FROM ()") + EXPECTED_MEMBER_COUNTERS_SQL + R"() AS fixed
+        WHERE members.id = fixed.id
+          AND (members.active_loans IS NOT fixed.expected_active OR ABS(members.outstanding_fines - fixed.expected_fines) > 0.005)
+    )";
+    if (!executeSQL(fix_books) || !executeSQL(fix_members)) {
+        return false;
+    }
+    if (!tx.commit()) {
+        std::cerr << "Failed to commit reconcileCounters transaction" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// With WAL a dedicated connection holds one read snapshot for the whole copy: readers never block the
+// writer there, and the snapshot keeps commits from other desks from restarting the backup. With the
+// rollback journal a read lock held between steps would block every commit, so each step borrows the
+// main connection instead; commits made through it are carried into the copy rather than restarting it.
+bool DatabaseManager::copyTo(sqlite3* dest, int pagesPerStep, std::chrono::milliseconds pause,
+                             const std::function<bool(const BackupProgress&)>& onStep) {
+    Connection snapshot;
+    bool useSnapshot = options.walMode && snapshot.open(dbPath, SQLITE_OPEN_READONLY, options);
+    if (useSnapshot && sqlite3_exec(snapshot.db, "BEGIN; SELECT COUNT(*) FROM sqlite_master;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        std::cerr << "Could not start the backup snapshot: " << sqlite3_errmsg(snapshot.db) << std::endl;
+        snapshot.close();
+        useSnapshot = false;
+    }
+
+    sqlite3_backup* backup = nullptr;
+    int pageSize = 4096;
+    {
+        ConnectionLease conn = writeConnection();
+        sqlite3* source = useSnapshot ? snapshot.db : conn->db;
+        CachedStatement stmt = conn->statements.acquire("PRAGMA page_size");
+        if (stmt && sqlite3_step(stmt) == SQLITE_ROW) pageSize = readColumn<int>(stmt, 0);
+        stmt.release();
+        backup = sqlite3_backup_init(dest, "main", source, "main");
+    }
+    if (!backup) {
+        std::cerr << "SQLite backup init failed: " << sqlite3_errmsg(dest) << std::endl;
+        return false;
+    }
+
+    BackupProgress progress;
+    auto started = std::chrono::steady_clock::now();
+    bool cancelled = false;
+    int rc;
+    do {
+        {
+            std::optional<ConnectionLease> lease;
+            if (!useSnapshot) lease.emplace(primary);
+            rc = sqlite3_backup_step(backup, pagesPerStep);
+            progress.pagesTotal = sqlite3_backup_pagecount(backup);
+            progress.pagesRemaining = sqlite3_backup_remaining(backup);
+        }
+        progress.bytesCopied = static_cast<std::int64_t>(progress.pagesTotal - progress.pagesRemaining) * pageSize;
+        progress.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        if (onStep && !onStep(progress)) {
+            cancelled = true;
+            break;
+        }
+        if (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED) {
+            std::this_thread::sleep_for(pause);
         }
+    } while (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED);
+
+    sqlite3_backup_finish(backup);
+    if (!cancelled && rc != SQLITE_DONE) {
+        std::cerr << "SQLite backup step failed: " << sqlite3_errstr(rc) << std::endl;
     }
+    return !cancelled && rc == SQLITE_DONE;
+}
+
+bool DatabaseManager::backupTo(const std::string& target, int pagesPerStep, std::chrono::milliseconds pause,
+                               const std::function<bool(const BackupProgress&)>& onStep) {
+    QueryTimer timer(stats, DbMethod::BackupTo);
+    std::string partial = target + ".part";
+    std::remove(partial.c_str());
 
-    if (!executeSQL("COMMIT;")) {
-        std::cerr << "Failed to commit updateLoan transaction" << std::endl;
-        executeSQL("ROLLBACK;");
+    sqlite3* dest = nullptr;
+    if (sqlite3_open_v2(partial.c_str(), &dest, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr) != SQLITE_OK) {
+        std::cerr << "Could not create backup file " << partial << ": " << (dest ? sqlite3_errmsg(dest) : "unknown") << std::endl;
+        sqlite3_close(dest);
         return false;
     }
+    bool ok = copyTo(dest, pagesPerStep, pause, onStep);
+    sqlite3_close(dest);
 
+    if (!ok) {
+        std::remove(partial.c_str());
+        return false;
+    }
+    std::remove(target.c_str());
+    if (std::rename(partial.c_str(), target.c_str()) != 0) {
+        std::cerr << "Could not move the backup into place: " << target << std::endl;
+        return false;
+    }
     return true;
 }
+
+bool DatabaseManager::snapshotInto(DatabaseManager& copy, int pagesPerStep, std::chrono::milliseconds pause,
+                                   const std::function<bool(const BackupProgress&)>& onStep) {
+    QueryTimer timer(stats, DbMethod::SnapshotInto);
+    bool ok;
+    {
+        ConnectionLease dest = copy.writeConnection();
+        if (!dest->db) {
+            std::cerr << "Snapshot target is not open: " << copy.dbPath << std::endl;
+            return false;
+        }
+        ok = copyTo(dest->db, pagesPerStep, pause, onStep);
+    }
+    copy.fullTextSearch = copy.hasSearchIndex();
+    return ok;
+}
+
+DataVersion DatabaseManager::getDataVersion(DataTable table) {
+    QueryTimer timer(stats, DbMethod::GetDataVersion);
+    // data_version is relative to the connection it is read from, so always use the main one.
+    ConnectionLease conn = writeConnection();
+    DataVersion version;
+    version.local = tableWrites[static_cast<int>(table)].load(std::memory_order_relaxed);
+
+    CachedStatement stmt = conn->statements.acquire("PRAGMA data_version");
+    if (stmt && sqlite3_step(stmt) == SQLITE_ROW) {
+        version.external = readColumn<std::int64_t>(stmt, 0);
+    }
+    return version;
+}
+
+StatementCacheStats DatabaseManager::getStatementCacheStats() {
+    QueryTimer timer(stats, DbMethod::GetStatementCacheStats);
+    ConnectionLease conn = writeConnection();
+    return conn->statements.getStats();
+}
+
+// Index statistics from sqlite_stat1: the row count of each table, and for each index the row count
+// followed by the average rows per distinct value of its first 1, 2, ... columns. Empty until ANALYZE.
+struct PlanStatistics {
+    std::vector<std::pair<std::string, std::int64_t>> tables;
+    std::vector<std::pair<std::string, std::vector<std::int64_t>>> indexes;
+
+    std::int64_t tableRows(const std::string& table) const {
+        for (const auto& [name, rows] : tables) if (name == table) return rows;
+        return -1;
+    }
+    const std::vector<std::int64_t>* index(const std::string& name) const {
+        for (const auto& entry : indexes) if (entry.first == name) return &entry.second;
+        return nullptr;
+    }
+};
+
+static std::string planWord(const std::string& detail, std::size_t at) {
+    std::size_t end = detail.find(' ', at);
+    return detail.substr(at, end == std::string::npos ? std::string::npos : end - at);
+}
+
+// Table names by the alias the plan uses for them ("FROM loans l", "JOIN books b")
+static std::vector<std::pair<std::string, std::string>> tableAliases(const std::string& sql) {
+    std::vector<std::string> words;
+    std::size_t pos = 0;
+    while (pos < sql.size()) {
+        while (pos < sql.size() && std::isspace(static_cast<unsigned char>(sql[pos]))) ++pos;
+        std::size_t end = pos;
+        while (end < sql.size() && !std::isspace(static_cast<unsigned char>(sql[end]))) ++end;
+        if (end > pos) words.push_back(sql.substr(pos, end - pos));
+        pos = end;
+    }
+    // Keywords are upper case in this file, aliases lower case
+    auto isAlias = [](const std::string& word) {
+        return std::all_of(word.begin(), word.end(), [](char c) { return std::islower(static_cast<unsigned char>(c)) || c == '_'; });
+    };
+    std::vector<std::pair<std::string, std::string>> aliases;
+    for (std::size_t i = 0; i + 2 < words.size(); ++i) {
+        if ((words[i] == "FROM" || words[i] == "JOIN") && isAlias(words[i + 2])) aliases.emplace_back(words[i + 2], words[i + 1]);
+    }
+    return aliases;
+}
+
+// Rows one SCAN or SEARCH step is expected to visit, -1 when the statistics do not say
+static std::int64_t estimateStepRows(const std::string& detail, const PlanStatistics& statistics,
+                                     const std::vector<std::pair<std::string, std::string>>& aliases) {
+    bool scan = detail.rfind("SCAN ", 0) == 0;
+    bool search = detail.rfind("SEARCH ", 0) == 0;
+    if (!scan && !search) return -1;
+    if (detail.find("INTEGER PRIMARY KEY (rowid=?)") != std::string::npos) return 1;
+
+    std::size_t at = detail.find("INDEX ");
+    if (at == std::string::npos || detail.find("AUTOMATIC") != std::string::npos) {
+        std::string table = planWord(detail, scan ? 5 : 7);
+        for (const auto& [alias, name] : aliases) if (alias == table) table = name;
+        return statistics.tableRows(table);
+    }
+    const std::vector<std::int64_t>* stat = statistics.index(planWord(detail, at + 6));
+    if (!stat || stat->empty()) return -1;
+
+    // Equality terms on the leading columns narrow the search to stat[k] rows per key
+    std::size_t equalities = 0;
+    for (std::size_t pos = detail.find("=?"); pos != std::string::npos; pos = detail.find("=?", pos + 2)) {
+        if (pos > 0 && detail[pos - 1] != '<' && detail[pos - 1] != '>') ++equalities;
+    }
+    return (*stat)[std::min(equalities, stat->size() - 1)];
+}
+
+// Values taken from the data so the hot queries are run the way the desk runs them
+struct PlanSamples {
+    SqlTime now = std::chrono::system_clock::now();
+    int memberId = 0;
+    std::string isbn;
+    std::string title;
+    std::string author;
+    std::string memberName;
+    int loanId = 0;
+    SqlTime loanDue;
+    std::string match;
+    int limit = 50;
+};
+
+static PlanSamples loadPlanSamples(Connection& conn) {
+    PlanSamples samples;
+    const char* sql = R"(
+        SELECT COALESCE((SELECT member_id FROM loans WHERE is_returned = 0 LIMIT 1), (SELECT MIN(id) FROM members), 0),
+               COALESCE((SELECT book_isbn FROM loans WHERE is_returned = 0 LIMIT 1), (SELECT MIN(isbn) FROM books), ''),
+               COALESCE((SELECT id FROM loans WHERE is_returned = 0 LIMIT 1), 0),
+               COALESCE((SELECT due_date FROM loans WHERE is_returned = 0 LIMIT 1), 0)
+    )";
+    CachedStatement stmt = conn.statements.acquire(sql);
+    if (stmt && sqlite3_step(stmt) == SQLITE_ROW) {
+        std::tie(samples.memberId, samples.isbn, samples.loanId, samples.loanDue) = readRow<int, std::string, int, SqlTime>(stmt);
+    }
+    stmt.release();
+
+    CachedStatement book = conn.statements.acquire("SELECT title, author FROM books WHERE isbn = ?1");
+    if (book && bindParams(book, samples.isbn) && sqlite3_step(book) == SQLITE_ROW) {
+        std::tie(samples.title, samples.author) = readRow<std::string, std::string>(book);
+    }
+    book.release();
+    CachedStatement member = conn.statements.acquire("SELECT name FROM members WHERE id = ?1");
+    if (member && bindParams(member, samples.memberId) && sqlite3_step(member) == SQLITE_ROW) {
+        samples.memberName = readColumn<std::string>(member, 0);
+    }
+    member.release();
+
+    samples.match = toMatchQuery(samples.title.substr(0, samples.title.find(' ')));
+    if (samples.match.empty()) samples.match = "\"a\"*";
+    return samples;
+}
+
+// Runs EXPLAIN QUERY PLAN over the queries the desk screens issue on every refresh. Any SCAN step
+// reads a whole table or index, which is only acceptable over a partial index (it holds just the
+// rows asked for) or for first pages that walk the ORDER BY order and stop at LIMIT. Ranked search
+// is the one query allowed to sort its matches, and none may need an automatic index.
+std::vector<QueryPlanReport> DatabaseManager::explainHotQueries(bool run) {
+    QueryTimer timer(stats, DbMethod::ExplainHotQueries);
+    using Binder = std::function<void(sqlite3_stmt*, const PlanSamples&)>;
+    struct HotQuery {
+        std::string name;
+        const char* sql;
+        bool orderedScan;   // reads the table in ORDER BY order and stops at LIMIT
+        bool sorts;         // ORDER BY needs a temporary b-tree by design
+        Binder bind;
+    };
+    auto none = [](sqlite3_stmt*, const PlanSamples&) {};
+    auto now = [](sqlite3_stmt* stmt, const PlanSamples& s) { bindParams(stmt, s.now); };
+    std::vector<HotQuery> queries = {
+        { "getActiveLoans", ACTIVE_LOANS_SQL, false, false, none },
+        { "getActiveLoanViews", ACTIVE_LOAN_VIEWS_SQL, false, false, none },
+        { "getOverdueLoans", OVERDUE_LOANS_SQL, false, false, now },
+        { "countActiveLoans", MEMBER_ACTIVE_LOANS_SQL, false, false,
+          [](sqlite3_stmt* stmt, const PlanSamples& s) { bindParams(stmt, s.memberId); } },
+        { "getMemberLoanCounts", MEMBER_LOAN_COUNTS_SQL, false, false,
+          [](sqlite3_stmt* stmt, const PlanSamples& s) { bindParams(stmt, s.now, s.memberId); } },
+        { "getMemberLoanCounts (all)", ALL_MEMBER_LOAN_COUNTS_SQL, false, false, now },
+        { "countCopiesOut", BOOK_COPIES_OUT_SQL, false, false,
+          [](sqlite3_stmt* stmt, const PlanSamples& s) { bindParams(stmt, s.isbn); } },
+        { "getLibrarySummary", ACTIVE_LOAN_TOTALS_SQL, false, false, now },
+    };
+    // Later pages continue after the sample row; ?1 is the sort value, ?2 the key, ?3 the page size
+    for (int sort = 0; sort < 3; ++sort) {
+        Binder page = [sort](sqlite3_stmt* stmt, const PlanSamples& s) {
+            bindParams(stmt, sort == 1 ? s.title : s.author, s.isbn, s.limit);
+        };
+        for (int next = 0; next < 2; ++next) {
+            queries.push_back({ "getBooksPage", BOOK_PAGE_SQL[sort][next], next == 0, false, page });
+            queries.push_back({ "getBookListPage", BOOK_LIST_PAGE_SQL[sort][next], next == 0, false, page });
+        }
+    }
+    for (int sort = 0; sort < 2; ++sort)
+        for (int next = 0; next < 2; ++next)
+            queries.push_back({ "getMembersPage", MEMBER_PAGE_SQL[sort][next], next == 0, false,
+                                [](sqlite3_stmt* stmt, const PlanSamples& s) { bindParams(stmt, s.memberName, s.memberId, s.limit); } });
+    for (int sort = 0; sort < 2; ++sort) {
+        Binder page = [](sqlite3_stmt* stmt, const PlanSamples& s) { bindParams(stmt, s.loanDue, s.loanId, s.limit); };
+        for (int next = 0; next < 2; ++next) {
+            queries.push_back({ "getLoansPage", LOAN_PAGE_SQL[sort][next], next == 0, false, page });
+            queries.push_back({ "getLoanViewsPage", LOAN_VIEW_PAGE_SQL[sort][next], next == 0, false, page });
+        }
+    }
+    if (fullTextSearch) {
+        Binder search = [](sqlite3_stmt* stmt, const PlanSamples& s) { bindParams(stmt, s.match, s.limit); };
+        queries.push_back({ "searchBooks", BOOK_SEARCH_SQL, false, true, search });
+        queries.push_back({ "searchBookList", BOOK_LIST_SEARCH_SQL, false, true, search });
+        queries.push_back({ "searchBookList (available)", BOOK_LIST_AVAILABLE_SEARCH_SQL, false, true, search });
+    }
+
+    ConnectionLease conn = readConnection();
+    std::vector<std::string> partialIndexes;
+    {
+        CachedStatement stmt = conn->statements.acquire(
+            "SELECT il.name FROM sqlite_master m, pragma_index_list(m.name) il WHERE m.type = 'table' AND il.partial = 1");
+        while (stmt && sqlite3_step(stmt) == SQLITE_ROW) {
+            partialIndexes.push_back(readColumn<std::string>(stmt, 0));
+        }
+    }
+    PlanStatistics statistics;
+    {
+        CachedStatement exists = conn->statements.acquire("SELECT 1 FROM sqlite_master WHERE name = 'sqlite_stat1'");
+        bool analyzed = exists && sqlite3_step(exists) == SQLITE_ROW;
+        exists.release();
+        CachedStatement stmt;
+        if (analyzed) stmt = conn->statements.acquire("SELECT tbl, idx, stat FROM sqlite_stat1");
+        while (stmt && sqlite3_step(stmt) == SQLITE_ROW) {
+            auto [table, index, stat] = readRow<std::string, std::optional<std::string>, std::string>(stmt);
+            std::vector<std::int64_t> numbers;
+            const char* at = stat.c_str();
+            char* end = nullptr;
+            for (long long value = std::strtoll(at, &end, 10); end != at; value = std::strtoll(at, &end, 10)) {
+                numbers.push_back(value);
+                at = end;
+            }
+            if (numbers.empty()) continue;
+            // A partial index counts only its own rows, so the table is as large as its largest entry
+            auto known = std::find_if(statistics.tables.begin(), statistics.tables.end(),
+                                      [&](const auto& entry) { return entry.first == table; });
+            if (known == statistics.tables.end()) statistics.tables.emplace_back(table, numbers[0]);
+            else known->second = std::max(known->second, numbers[0]);
+            if (index) statistics.indexes.emplace_back(*index, std::move(numbers));
+        }
+    }
+    PlanSamples samples;
+    if (run) samples = loadPlanSamples(*conn);
+
+    std::vector<QueryPlanReport> reports;
+    reports.reserve(queries.size());
+    for (const auto& query : queries) {
+        QueryPlanReport report;
+        report.name = query.name;
+        report.sql = query.sql;
+        auto aliases = tableAliases(report.sql);
+
+        sqlite3_stmt* explain = nullptr;
+        std::string explain_sql = std::string("EXPLAIN QUERY PLAN ") + query.sql;
+        if (sqlite3_prepare_v2(conn->db, explain_sql.c_str(), -1, &explain, nullptr) != SQLITE_OK) {
+            report.error = sqlite3_errmsg(conn->db);
+            report.regressed = true;
+            reports.push_back(std::move(report));
+            continue;
+        }
+        bool outerLoop = false;
+        while (sqlite3_step(explain) == SQLITE_ROW) {
+            auto [id, parent] = readRow<int, int>(explain);
+            std::string detail = readColumn<std::string>(explain, 3);
+            QueryPlanStep step{ id, parent, detail, estimateStepRows(detail, statistics, aliases) };
+            if (detail.rfind("SCAN ", 0) == 0 && detail.find("VIRTUAL TABLE") == std::string::npos) {
+                std::size_t at = detail.find("INDEX ");
+                std::string index = at == std::string::npos ? std::string() : planWord(detail, at + 6);
+                if (std::find(partialIndexes.begin(), partialIndexes.end(), index) == partialIndexes.end()) report.fullScan = true;
+            }
+            if (detail.rfind("USE TEMP B-TREE FOR", 0) == 0) report.tempBTree = true;
+            if (detail.find("AUTOMATIC") != std::string::npos) report.autoIndex = true;
+            // The first loop of the plan decides how many rows the query walks
+            bool loop = detail.rfind("SCAN ", 0) == 0 || detail.rfind("SEARCH ", 0) == 0;
+            if (loop && !outerLoop) {
+                outerLoop = true;
+                report.estimatedRows = step.estimatedRows;
+            }
+            report.steps.push_back(std::move(step));
+        }
+        sqlite3_finalize(explain);
+        report.regressed = (report.fullScan && !query.orderedScan) || (report.tempBTree && !query.sorts) || report.autoIndex;
+
+        if (run) {
+            CachedStatement stmt = conn->statements.acquire(query.sql);
+            if (!stmt) {
+                report.error = sqlite3_errmsg(conn->db);
+            } else {
+                query.bind(stmt, samples);
+                auto started = std::chrono::steady_clock::now();
+                int rows = 0;
+                int rc;
+                while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) ++rows;
+                report.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+                if (rc == SQLITE_DONE) report.actualRows = rows;
+                else report.error = sqlite3_errmsg(conn->db);
+            }
+        }
+        reports.push_back(std::move(report));
+    }
+    timer.rows(reports.size());
+    return reports;
+}
+
+bool DatabaseManager::checkQueryPlans() {
+    QueryTimer timer(stats, DbMethod::CheckQueryPlans);
+    bool ok = true;
+    for (const auto& report : explainHotQueries(false)) {
+        if (!report.error.empty()) {
+            std::cerr << "SQLite prepare failed (checkQueryPlans, " << report.name << "): " << report.error << std::endl;
+            ok = false;
+            continue;
+        }
+        if (!report.regressed) continue;
+
+        std::string plan;
+        for (const auto& step : report.steps) plan += "\n    " + step.detail;
+        const char* why = report.autoIndex ? " builds an automatic index"
+                        : report.fullScan ? " scans a whole table or index" : " sorts its whole result";
+        std::cerr << "QUERY PLAN CHECK FAILED: " << report.name << why << "\n  " << report.sql << plan << std::endl;
+        ok = false;
+    }
+    return ok;
+}
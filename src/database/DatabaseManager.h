@@ -2,41 +2,327 @@
 #include <string>
 #include <vector>
 #include <optional>
+#include <atomic>
+#include <cstdint>
+#include <chrono>
 #include <sqlite3.h>
 #include "../core/Book.h"
 #include "../core/Member.h"
 #include "../core/Loan.h"
+#include <thread>
+#include <functional>
+#include <utility>
+#include "StatementCache.h"
+#include "ConnectionPool.h"
+#include "RowCursor.h"
+#include "QueryStats.h"
+#include "SlowQueryLog.h"
+
+enum class DataTable { Books = 0, Members, Loans, Users, Count };
+
+// Cheap change token for a table. `external` is PRAGMA data_version, which moves whenever another
+// connection (or process) commits to the file; `local` counts rows written to the table through this
+// connection. Equal tokens mean the table has not changed since the token was taken.
+struct DataVersion {
+    std::int64_t external = -1;
+    std::uint64_t local = 0;
+
+    bool operator==(const DataVersion& other) const = default;
+};
+
+enum class CheckoutResult { Ok = 0, BookNotFound, NoCopiesAvailable, MemberNotFound, LimitReached, Failed };
+
+// A loan row joined with the title of its book and the name of its member. Either is empty when
+// the book or member row no longer exists.
+struct LoanView {
+    Loan loan;
+    std::string bookTitle;
+    std::string memberName;
+};
+
+// Compact rows for the lists that refresh most often: only the columns those lists show. A row
+// opened for editing is fetched whole with findBook / findMember.
+struct BookListItem {
+    std::string isbn;
+    std::string title;
+    std::string author;
+    int publicationYear = 0;
+    int totalCopies = 0;
+    int availableCopies = 0;
+    Book::Status status = Book::Status::AVAILABLE;
+
+    bool isAvailable() const { return status == Book::Status::AVAILABLE && availableCopies > 0; }
+};
+
+struct MemberListItem {
+    int id = 0;
+    std::string name;
+    std::string phone;
+    int maxBooksAllowed = 0;
+};
+
+// Unreturned loans of one member; `overdue` is the part of `active` past its due date.
+struct MemberLoanCounts {
+    int memberId = 0;
+    int active = 0;
+    int overdue = 0;
+};
+
+struct MemberTypeTotals {
+    Member::Type type = Member::Type::STUDENT;
+    int members = 0;
+    int activeLoans = 0;
+    int overdueLoans = 0;
+};
+
+// Result of reconcileCounters(): rows whose stored counter disagreed with the loans table.
+struct CounterDrift {
+    int books = 0;
+    int members = 0;
+    std::vector<std::string> details;   // the first few drifted rows, for the log
+
+    bool empty() const { return books == 0 && members == 0; }
+};
+
+// Report rows. These scan the whole loan history, so run them on a ReportingSnapshot rather than on
+// the desk's database.
+struct MemberFineReport {
+    int memberId = 0;
+    std::string name;
+    int loans = 0;
+    int lateReturns = 0;
+    double fines = 0.0;
+};
+
+struct CirculationMonth {
+    std::string month;   // YYYY-MM, local time
+    int loans = 0;
+    int returned = 0;
+    int lateReturns = 0;
+    double fines = 0.0;
+};
+
+struct BackupProgress {
+    int pagesTotal = 0;
+    int pagesRemaining = 0;
+    std::int64_t bytesCopied = 0;
+    double seconds = 0.0;
+
+    double mibPerSecond() const { return seconds > 0.0 ? bytesCopied / (1024.0 * 1024.0) / seconds : 0.0; }
+};
+
+// One row of EXPLAIN QUERY PLAN, with the rows sqlite_stat1 says the step visits (-1 when unknown,
+// e.g. before the first ANALYZE).
+struct QueryPlanStep {
+    int id = 0;
+    int parent = 0;
+    std::string detail;
+    std::int64_t estimatedRows = -1;
+};
+
+struct QueryPlanReport {
+    std::string name;                 // the DatabaseManager method that issues the query
+    std::string sql;
+    std::vector<QueryPlanStep> steps;
+    bool fullScan = false;            // reads a whole table or non-partial index
+    bool tempBTree = false;           // sorts or groups through a temporary b-tree
+    bool autoIndex = false;           // SQLite builds an index on the fly, so one is missing
+    bool regressed = false;           // any of the above where the query is not designed for it
+    std::int64_t estimatedRows = -1;  // estimate for the outermost loop
+    int actualRows = -1;              // rows returned with the sample parameters; -1 if not run
+    double ms = 0.0;
+    std::string error;
+};
+
+struct LibrarySummary {
+    int titles = 0;
+    int totalCopies = 0;
+    int availableCopies = 0;
+    int unavailableTitles = 0;   // titles with every copy out
+    int activeLoans = 0;
+    int overdueLoans = 0;
+};
+
+enum class BookSort { Isbn = 0, Title, Author };
+enum class MemberSort { Id = 0, Name };
+enum class LoanSort { Id = 0, DueDate };
+
+// Keyset page positions: the sort value and unique key of the last row of the previous page.
+// Pass std::nullopt to fetch the first page.
+struct BookPageKey {
+    std::string sortValue;
+    std::string isbn;
+};
+
+struct MemberPageKey {
+    std::string sortValue;
+    int id = 0;
+};
+
+struct LoanPageKey {
+    std::int64_t sortValue = 0;
+    int id = 0;
+};
 
 class DatabaseManager {
 private:
     std::string dbPath;
-    sqlite3* db;
+    StorageOptions options;
+    SharedConnection primary;
+    ConnectionPool readers;
+    std::thread::id deskThread;
+    std::atomic<std::uint64_t> tableWrites[static_cast<int>(DataTable::Count)] = {};
+    std::atomic<bool> fullTextSearch{false};   // books_fts exists; false until its migration ran, or without FTS5
+    QueryStats stats;
+    SlowQueryLog slowQueries;
 
     bool executeSQL(const std::string& sql);
-    bool createTables();
+    bool copyTo(sqlite3* dest, int pagesPerStep, std::chrono::milliseconds pause,
+                const std::function<bool(const BackupProgress&)>& onStep);
+    bool migrateTo(int target, bool background);
+    bool migrationApplied(int version);
+    std::vector<int> stepsAhead();
+    bool recordMigration(int version);
+    bool hasSearchIndex();
+    std::vector<std::pair<std::string, std::string>> droppedByImport();
+    bool restoreDroppedByImport();
+    template <typename Row>
+    std::vector<Row> loadRowidRanges(const char* table, const char* sql, int threads);
+    template <typename Row>
+    std::vector<Row> searchBookRows(const char* ftsSql, const char* scanSql, const std::string& query, int limit);
+    ConnectionLease readConnection();
+    ConnectionLease writeConnection();
+    static void onRowChanged(void* self, int op, const char* dbName, const char* table, sqlite3_int64 rowid);
 
 public:
-    DatabaseManager(const std::string& path = "data/library.db");
+    DatabaseManager(const std::string& path = "data/library.db", const StorageOptions& storage = StorageOptions());
     ~DatabaseManager();
     
     bool initialize();
+    const StorageOptions& storageOptions() const { return options; }
+    // PRAGMA user_version of the file: every step up to it is applied. -1 if it cannot be read
+    int schemaVersion();
+    bool migrationsPending();
+    // Applies the background (index-only) migrations that initialize() left out, then re-checks the
+    // query plans. Slow on a large file; run it on the database worker once the window is up.
+    bool runPendingMigrations();
    
     bool validateLogin(const std::string& username, const std::string& password, int& outUserId);
 
     bool addBook(const Book& book);
+    // Writes the catalogue fields and total_copies; available copies and status follow from the
+    // stored counts, so the book's own available_copies and status are ignored
     bool updateBook(const Book& book);
     bool deleteBook(const std::string& isbn);
     std::vector<Book> getAllBooks();
+    // Streaming variants: rows are decoded as the statement steps. A visitor returns false to stop
+    // early, in which case forEach* returns false as well.
+    RowCursor<Book> openBookCursor();
+    bool forEachBook(const std::function<bool(const Book&)>& visitor);
+    std::vector<Book> getBooksPage(const std::optional<BookPageKey>& after, int limit, BookSort sort = BookSort::Isbn);
+    static BookPageKey bookPageKey(const Book& book, BookSort sort);
+    int countBooks();
     std::optional<Book> findBook(const std::string& isbn);
+    // Best matches first for every word of the query as a prefix of the title, author or ISBN.
+    std::vector<Book> searchBooks(const std::string& query, int limit = 500);
+    // Projections of the above for list views
+    std::vector<BookListItem> getBookList(bool availableOnly = false);
+    std::vector<BookListItem> getBookListPage(const std::optional<BookPageKey>& after, int limit, BookSort sort = BookSort::Isbn);
+    static BookPageKey bookPageKey(const BookListItem& book, BookSort sort);
+    std::vector<BookListItem> searchBookList(const std::string& query, bool availableOnly = false, int limit = 500);
+    bool rebuildSearchIndex();
     
     bool addMember(const Member& member);
     bool updateMember(const Member& member);
     bool deleteMember(int id);
     std::vector<Member> getAllMembers();
+    RowCursor<Member> openMemberCursor();
+    bool forEachMember(const std::function<bool(const Member&)>& visitor);
+    std::vector<Member> getMembersPage(const std::optional<MemberPageKey>& after, int limit, MemberSort sort = MemberSort::Id);
+    static MemberPageKey memberPageKey(const Member& member, MemberSort sort);
+    int countMembers();
     std::optional<Member> findMember(int id);
+    std::vector<MemberListItem> getMemberList();   // by id
     
+    // Records the loan with a single guarded INSERT; triggers take the copy and bump the member's count.
+    // The copy count and the member's limit are checked by the INSERT itself, so concurrent desks
+    // cannot overbook.
+    CheckoutResult checkout(const Loan& loan, int* loanId = nullptr);
+    // Checks out a stack of books for one member with a single commit. Each book gets its own result;
+    // refused books do not affect the others.
+    std::vector<CheckoutResult> checkoutBatch(int memberId, const std::vector<std::string>& isbns, int days);
     bool addLoan(const Loan& loan);
     bool updateLoan(const Loan& loan);
+    // Checks in many loans at once with one UPDATE: fines are computed in SQL and triggers restore the
+    // copies. Loans already returned are skipped; `returned` receives how many were checked in.
+    bool returnBatch(const std::vector<int>& loanIds, std::chrono::system_clock::time_point returnTime, int* returned = nullptr);
+    // Runs unrelated writes under one commit, each in a savepoint of its own: a write that returns
+    // false is rolled back alone and the others still commit. Returns, per write, whether its outcome
+    // stands; false for every write the transaction lost (failed commit, or SQLite rolling back
+    // after an I/O error). DatabaseWorker::submitWrite groups desk writes through this.
+    std::vector<bool> groupCommit(const std::vector<std::function<bool(DatabaseManager&)>>& writes);
     std::vector<Loan> getAllLoans();
+    // Same rows as getAllLoans, read in rowid ranges by `threads` threads (0 = one per core), each on
+    // its own read-only connection. Each range is read from one consistent snapshot, but the ranges
+    // are not read from the same one: writes through this manager wait until the load is done, while
+    // another process on the same file can commit between two ranges. Meant for cold starts; do not
+    // call it inside a transaction.
+    std::vector<Loan> getAllLoansParallel(int threads = 0);
+    RowCursor<Loan> openLoanCursor();
+    bool forEachLoan(const std::function<bool(const Loan&)>& visitor);
+    std::vector<Loan> getLoansPage(const std::optional<LoanPageKey>& after, int limit, LoanSort sort = LoanSort::Id);
+    static LoanPageKey loanPageKey(const Loan& loan, LoanSort sort);
+    int countLoans();
     std::vector<Loan> getActiveLoans();
+    // Loan screens read these instead of joining titles and names against cached vectors.
+    std::vector<LoanView> getLoanViewsPage(const std::optional<LoanPageKey>& after, int limit, LoanSort sort = LoanSort::Id);
+    std::vector<LoanView> getActiveLoanViews();   // by due date
+    std::vector<Loan> getOverdueLoans();
+    int countActiveLoans(int memberId);
+
+    // Aggregates computed by indexed GROUP BY queries over unreturned loans only, never loan history.
+    MemberLoanCounts getMemberLoanCounts(int memberId);
+    std::vector<MemberLoanCounts> getMemberLoanCounts();   // members with at least one active loan, by id
+    int countCopiesOut(const std::string& isbn);
+    std::vector<MemberTypeTotals> getMemberTypeTotals();
+    LibrarySummary getLibrarySummary();
+
+    // Members by total fines over their whole loan history, highest first
+    std::vector<MemberFineReport> getFineReport(int limit = 100);
+    // Loans, returns and fines per month of checkout, newest first
+    std::vector<CirculationMonth> getCirculationReport(int months = 24);
+
+    // Recomputes books.available_copies, members.active_loans and members.outstanding_fines from the
+    // loans table in one transaction and reports the rows that had drifted from it. First restores any
+    // indexes and triggers an unfinished BulkImporter run left dropped.
+    bool reconcileCounters(CounterDrift& drift);
+
+    // Online copy of the database into `target` through sqlite3_backup_step, `pagesPerStep` pages at a
+    // time with `pause` between steps so desk writes are not held up. `onStep` sees the progress after
+    // every step and may return false to cancel. The copy is written next to `target` and renamed into
+    // place once complete, so `target` never holds a torn file.
+    bool backupTo(const std::string& target, int pagesPerStep, std::chrono::milliseconds pause,
+                  const std::function<bool(const BackupProgress&)>& onStep = nullptr);
+    // Same stepped copy, straight into another manager's database (replacing its contents). Used to
+    // refresh the reporting snapshot without a file rename.
+    bool snapshotInto(DatabaseManager& copy, int pagesPerStep, std::chrono::milliseconds pause,
+                      const std::function<bool(const BackupProgress&)>& onStep = nullptr);
+
+    // EXPLAIN QUERY PLAN of every hot query. With `run`, each is also executed with parameters taken
+    // from the data (a member and a book with loans, pages after them) to count its rows.
+    std::vector<QueryPlanReport> explainHotQueries(bool run = true);
+    // The same check without running anything; false (with details on stderr) if any query regressed.
+    bool checkQueryPlans();
+    // ANALYZE, so the planner and the row estimates above see the current table sizes
+    bool updateStatistics();
+
+    DataVersion getDataVersion(DataTable table);
+    StatementCacheStats getStatementCacheStats();
+    // Latency of every public method above since startup (or the last reset); open*Cursor times only the
+    // prepare, the rows are stepped by the caller. Safe to read from any thread.
+    QueryStats& queryStats() { return stats; }
+    // Statements slower than `threshold` are logged with their bound values and step counts to
+    // <database>.slow.log next to the file. Zero removes the trace callback from every connection.
+    void setSlowQueryThreshold(std::chrono::milliseconds threshold);
+    SlowQueryLog& slowQueryLog() { return slowQueries; }
 };
@@ -0,0 +1,136 @@
+#include "DatabaseWorker.h"
+#include <chrono>
+
+// How often an idle worker looks for commits made by other connections or processes
+static constexpr std::chrono::milliseconds IDLE_VERSION_CHECK(250);
+
+DatabaseWorker::DatabaseWorker(DatabaseManager& db, const GroupCommit& grouping) : db(db), grouping(grouping) {
+    publishVersions();
+    thread = std::thread(&DatabaseWorker::run, this);
+}
+
+DatabaseWorker::~DatabaseWorker() {
+    stop();
+}
+
+void DatabaseWorker::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) return;
+        stopping = true;
+    }
+    wake.notify_one();
+    if (thread.joinable()) thread.join();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    completions.clear();
+}
+
+void DatabaseWorker::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        if (jobs.empty()) {
+            if (stopping) break;
+            if (!wake.wait_for(lock, IDLE_VERSION_CHECK, [this] { return !jobs.empty() || stopping; })) {
+                lock.unlock();
+                publishVersions();
+                lock.lock();
+            }
+            continue;
+        }
+
+        Task task = std::move(jobs.front());
+        jobs.pop_front();
+        if (!task.apply) {
+            lock.unlock();
+            task.run();
+            publishVersions();
+            pendingJobs.fetch_sub(1);
+            lock.lock();
+            continue;
+        }
+
+        // Gather the writes queued behind this one, waiting up to the window for more. The group
+        // ends at the first job that is not a write, which then runs after the commit.
+        std::vector<Task> group;
+        group.push_back(std::move(task));
+        auto deadline = std::chrono::steady_clock::now() + grouping.window;
+        while (grouping.enabled && static_cast<int>(group.size()) < grouping.maxWrites) {
+            if (!jobs.empty()) {
+                if (!jobs.front().apply) break;
+                group.push_back(std::move(jobs.front()));
+                jobs.pop_front();
+                continue;
+            }
+            if (stopping || grouping.window.count() <= 0 ||
+                !wake.wait_until(lock, deadline, [this] { return !jobs.empty() || stopping; })) {
+                break;
+            }
+        }
+
+        lock.unlock();
+        runWrites(group);
+        publishVersions();
+        pendingJobs.fetch_sub(static_cast<int>(group.size()));
+        lock.lock();
+    }
+}
+
+void DatabaseWorker::runWrites(std::vector<Task>& group) {
+    // A lone write already commits by itself; the savepoint would only add work
+    if (group.size() == 1) {
+        group[0].apply(db);
+        group[0].finish(true);
+        return;
+    }
+
+    std::vector<std::function<bool(DatabaseManager&)>> writes;
+    writes.reserve(group.size());
+    for (auto& task : group) writes.push_back(std::move(task.apply));
+    std::vector<bool> kept = db.groupCommit(writes);
+    for (size_t i = 0; i < group.size(); ++i) group[i].finish(kept[i]);
+}
+
+void DatabaseWorker::enqueue(Job job) {
+    Task task;
+    task.run = std::move(job);
+    enqueue(std::move(task));
+}
+
+void DatabaseWorker::enqueue(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) return;
+        jobs.push_back(std::move(task));
+        pendingJobs.fetch_add(1);
+    }
+    wake.notify_one();
+}
+
+void DatabaseWorker::complete(Job completion) {
+    std::lock_guard<std::mutex> lock(mutex);
+    completions.push_back(std::move(completion));
+}
+
+void DatabaseWorker::poll() {
+    std::deque<Job> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ready.swap(completions);
+    }
+    for (auto& completion : ready) completion();
+}
+
+void DatabaseWorker::publishVersions() {
+    DataVersion current[static_cast<int>(DataTable::Count)];
+    for (int i = 0; i < static_cast<int>(DataTable::Count); ++i) {
+        current[i] = db.getDataVersion(static_cast<DataTable>(i));
+    }
+    std::lock_guard<std::mutex> lock(versionsMutex);
+    for (int i = 0; i < static_cast<int>(DataTable::Count); ++i) versions[i] = current[i];
+}
+
+DataVersion DatabaseWorker::dataVersion(DataTable table) const {
+    std::lock_guard<std::mutex> lock(versionsMutex);
+    return versions[static_cast<int>(table)];
+}
@@ -0,0 +1,148 @@
+#pragma once
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <optional>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <type_traits>
+#include <condition_variable>
+#include "DatabaseManager.h"
+
+// Runs DatabaseManager calls on a dedicated thread so a slow fsync or a long scan never stalls a
+// frame. Jobs run one at a time in submission order, so a read queued after a write sees it. Each
+// job may carry a completion; completions are handed back to the UI thread and run from poll(),
+// which the window calls once per frame.
+//
+// The worker also publishes the data versions of every table after each job and on an idle tick,
+// so screens can check for changes without touching SQLite themselves.
+//
+//     worker.submit([](DatabaseManager& db) { return db.countBooks(); },
+//                   [this](int count) { pagedBooks.reset(count); });
+
+// Group commit for submitWrite(): writes queued back to back share one transaction, so a burst of
+// desk edits pays for one commit (one fsync under synchronous=FULL) instead of one each. Any other
+// job ends a group, so jobs still run in submission order.
+//
+// Durability: a write's completion runs only after its group committed, so a reported success is as
+// durable as StorageOptions::synchronous makes any commit (FULL: on disk; NORMAL with WAL: may be
+// lost to a power cut, never torn). A crash before the commit loses the whole group, none of which
+// had been reported yet. `window` is how long the first write of a group waits for company, so it
+// is also the most latency a lone write gains; zero only groups writes that are already queued.
+struct GroupCommit {
+    bool enabled = true;
+    std::chrono::milliseconds window{2};
+    int maxWrites = 64;
+};
+
+// How submitWrite() tells a write that succeeded, and what a write reports when its group was lost
+template <typename T>
+struct WriteOutcome;
+template <>
+struct WriteOutcome<bool> {
+    static bool succeeded(bool ok) { return ok; }
+    static bool lost() { return false; }
+};
+template <>
+struct WriteOutcome<CheckoutResult> {
+    static bool succeeded(CheckoutResult result) { return result == CheckoutResult::Ok; }
+    static CheckoutResult lost() { return CheckoutResult::Failed; }
+};
+
+class DatabaseWorker {
+private:
+    using Job = std::function<void()>;
+
+    // A queued job; a write also has `apply` (run inside the group, true on success) and `finish`
+    // (told whether the write's outcome survived its group's commit).
+    struct Task {
+        Job run;
+        std::function<bool(DatabaseManager&)> apply;
+        std::function<void(bool)> finish;
+    };
+
+    DatabaseManager& db;
+    GroupCommit grouping;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Task> jobs;
+    std::deque<Job> completions;
+    std::atomic<int> pendingJobs{0};
+    bool stopping = false;
+
+    mutable std::mutex versionsMutex;
+    DataVersion versions[static_cast<int>(DataTable::Count)];
+
+    void run();
+    void enqueue(Job job);
+    void enqueue(Task task);
+    void runWrites(std::vector<Task>& group);
+    void complete(Job completion);
+    void publishVersions();
+
+public:
+    explicit DatabaseWorker(DatabaseManager& db, const GroupCommit& grouping = GroupCommit());
+    ~DatabaseWorker();
+    DatabaseWorker(const DatabaseWorker&) = delete;
+    DatabaseWorker& operator=(const DatabaseWorker&) = delete;
+
+    // `work` runs on the worker thread with the manager; `done` runs on the UI thread with its result.
+    template <typename Work, typename Done>
+    void submit(Work work, Done done) {
+        using Result = std::invoke_result_t<Work&, DatabaseManager&>;
+        enqueue([this, work = std::move(work), done = std::move(done)]() mutable {
+            if constexpr (std::is_void_v<Result>) {
+                work(db);
+                complete(std::move(done));
+            } else {
+                complete([done = std::move(done), result = work(db)]() mutable { done(std::move(result)); });
+            }
+        });
+    }
+
+    template <typename Work>
+    void submit(Work work) {
+        enqueue([this, work = std::move(work)]() mutable { work(db); });
+    }
+
+    // A single write (returning bool or CheckoutResult) that may share a commit with the writes queued
+    // around it, see GroupCommit. `done` gets the write's own result once it is committed, or the
+    // failure value of WriteOutcome if its group could not commit.
+    template <typename Work, typename Done>
+    void submitWrite(Work work, Done done) {
+        using Result = std::invoke_result_t<Work&, DatabaseManager&>;
+        auto result = std::make_shared<std::optional<Result>>();
+        Task task;
+        task.apply = [work = std::move(work), result](DatabaseManager& manager) mutable {
+            *result = work(manager);
+            return WriteOutcome<Result>::succeeded(**result);
+        };
+        task.finish = [this, done = std::move(done), result](bool kept) mutable {
+            Result value = kept && *result ? std::move(**result) : WriteOutcome<Result>::lost();
+            complete([done = std::move(done), value]() mutable { done(value); });
+        };
+        enqueue(std::move(task));
+    }
+
+    template <typename Work>
+    void submitWrite(Work work) {
+        using Result = std::invoke_result_t<Work&, DatabaseManager&>;
+        submitWrite(std::move(work), [](Result) {});
+    }
+
+    // Runs the completions of finished jobs. Call from the UI thread only.
+    void poll();
+
+    // Jobs queued or running
+    int pending() const { return pendingJobs.load(); }
+
+    // Versions as of the last job or idle tick; compare with a version taken earlier to spot changes.
+    DataVersion dataVersion(DataTable table) const;
+
+    // Finishes every queued job, then joins the thread. Completions not yet polled are dropped.
+    void stop();
+};
@@ -0,0 +1,205 @@
+#include "Migrations.h"
+
+// Steps up to 5 are idempotent, so files created before user_version was tracked (version 0 with
+// the tables already in place) go through the same steps as new ones.
+static const std::vector<Migration> MIGRATIONS = {
+    { 1, "library tables", false, R"(
+        CREATE TABLE IF NOT EXISTS books (
+            isbn TEXT PRIMARY KEY,
+            title TEXT NOT NULL,
+            author TEXT NOT NULL,
+            genre TEXT,
+            publication_year INTEGER,
+            total_copies INTEGER,
+            available_copies INTEGER,
+            status INTEGER
+        );
+        CREATE TABLE IF NOT EXISTS members (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            name TEXT NOT NULL,
+            email TEXT UNIQUE,
+            phone TEXT,
+            member_type INTEGER,
+            max_books_allowed INTEGER
+        );
+        CREATE TABLE IF NOT EXISTS loans (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            book_isbn TEXT NOT NULL,
+            member_id INTEGER NOT NULL,
+            loan_date INTEGER NOT NULL,
+            due_date INTEGER NOT NULL,
+            return_date INTEGER,
+            is_returned INTEGER DEFAULT 0,
+            fine_amount REAL DEFAULT 0.0,
+            FOREIGN KEY (book_isbn) REFERENCES books (isbn) ON DELETE CASCADE,
+            FOREIGN KEY (member_id) REFERENCES members (id) ON DELETE CASCADE
+        );
+        CREATE TABLE IF NOT EXISTS users (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            username TEXT UNIQUE NOT NULL,
+            password_hash TEXT NOT NULL
+        );
+        INSERT INTO users (username, password_hash)
+        VALUES ('admin', '8c6976e5b5410415bde908bd4dee15dfb167a9c873fc4bb8a81f6f2ab448a918')
+        ON CONFLICT(username) DO UPDATE SET password_hash=excluded.password_hash;
+    )" },
+
+    // Ordered indexes backing the keyset-paginated list queries
+    { 2, "paging indexes", true, R"(
+        CREATE INDEX IF NOT EXISTS idx_books_title ON books (title, isbn);
+        CREATE INDEX IF NOT EXISTS idx_books_author ON books (author, isbn);
+        CREATE INDEX IF NOT EXISTS idx_members_name ON members (name, id);
+        CREATE INDEX IF NOT EXISTS idx_loans_due_date ON loans (due_date, id);
+    )" },
+
+    // Loan hot paths. The foreign key indexes also keep ON DELETE CASCADE from scanning loans; the
+    // partial index covers the active-loan listing and overdue lookups without touching history.
+    { 3, "loan indexes", true, R"(
+        CREATE INDEX IF NOT EXISTS idx_loans_member ON loans (member_id, is_returned);
+        CREATE INDEX IF NOT EXISTS idx_loans_book ON loans (book_isbn, is_returned);
+        CREATE INDEX IF NOT EXISTS idx_loans_active ON loans (due_date, member_id, book_isbn, loan_date) WHERE is_returned = 0;
+    )" },
+
+    // External-content FTS5 index over the searchable book columns. The triggers keep it in step with
+    // books; copy counts are not indexed, so checkouts and returns never touch it. books has no INTEGER
+    // PRIMARY KEY, so a VACUUM may renumber its rowids: call rebuildSearchIndex() after one. Fails on
+    // a SQLite built without FTS5, in which case book search keeps using LIKE scans.
+    { 4, "book search index", true, R"(
+        CREATE VIRTUAL TABLE IF NOT EXISTS books_fts USING fts5 (
+            isbn, title, author,
+            content = 'books', content_rowid = 'rowid',
+            tokenize = 'unicode61 remove_diacritics 2', prefix = '2 3'
+        );
+        CREATE TRIGGER IF NOT EXISTS books_fts_insert AFTER INSERT ON books BEGIN
+            INSERT INTO books_fts (rowid, isbn, title, author) VALUES (new.rowid, new.isbn, new.title, new.author);
+        END;
+        CREATE TRIGGER IF NOT EXISTS books_fts_delete AFTER DELETE ON books BEGIN
+            INSERT INTO books_fts (books_fts, rowid, isbn, title, author) VALUES ('delete', old.rowid, old.isbn, old.title, old.author);
+        END;
+        CREATE TRIGGER IF NOT EXISTS books_fts_update AFTER UPDATE OF isbn, title, author ON books BEGIN
+            INSERT INTO books_fts (books_fts, rowid, isbn, title, author) VALUES ('delete', old.rowid, old.isbn, old.title, old.author);
+            INSERT INTO books_fts (rowid, isbn, title, author) VALUES (new.rowid, new.isbn, new.title, new.author);
+        END;
+        INSERT INTO books_fts (books_fts) VALUES ('rebuild');
+    )" },
+
+    // Per-member aggregates: active loans grouped by member straight off the index, no sort step
+    { 5, "active loans by member index", true, R"(
+        CREATE INDEX IF NOT EXISTS idx_loans_active_member ON loans (member_id, due_date) WHERE is_returned = 0;
+    )" },
+
+    // Counters kept by triggers on loans, so checkout and return are a single INSERT or UPDATE. A loan
+    // holds a copy of its book and counts against its member while is_returned = 0; its fine counts
+    // towards the member's outstanding fines. DatabaseManager::reconcileCounters() recomputes them all.
+    // Step 7 replaces these triggers; this step stays as released.
+    { 6, "loan counters", false, R"(
+        ALTER TABLE members ADD COLUMN active_loans INTEGER NOT NULL DEFAULT 0;
+        ALTER TABLE members ADD COLUMN outstanding_fines REAL NOT NULL DEFAULT 0.0;
+        UPDATE members
+        SET active_loans = c.active, outstanding_fines = c.fines
+        FROM (SELECT member_id, SUM(is_returned = 0) AS active, SUM(fine_amount) AS fines
+              FROM loans GROUP BY member_id) AS c
+        WHERE members.id = c.member_id;
+
+        CREATE TRIGGER loans_counters_insert AFTER INSERT ON loans BEGIN
+            UPDATE books
+            SET available_copies = available_copies - 1,
+                status = CASE WHEN available_copies > 1 THEN 0 ELSE 1 END
+            WHERE isbn = new.book_isbn AND new.is_returned = 0;
+            UPDATE members
+            SET active_loans = active_loans + (new.is_returned = 0),
+                outstanding_fines = outstanding_fines + new.fine_amount
+            WHERE id = new.member_id;
+        END;
+        CREATE TRIGGER loans_counters_delete AFTER DELETE ON loans BEGIN
+            UPDATE books
+            SET available_copies = MIN(total_copies, available_copies + 1), status = 0
+            WHERE isbn = old.book_isbn AND old.is_returned = 0;
+            UPDATE members
+            SET active_loans = active_loans - (old.is_returned = 0),
+                outstanding_fines = outstanding_fines - old.fine_amount
+            WHERE id = old.member_id;
+        END;
+        CREATE TRIGGER loans_counters_update AFTER UPDATE OF book_isbn, member_id, is_returned, fine_amount ON loans BEGIN
+            UPDATE books
+            SET available_copies = MIN(total_copies, available_copies + 1), status = 0
+            WHERE isbn = old.book_isbn AND old.is_returned = 0;
+            UPDATE books
+            SET available_copies = available_copies - 1,
+                status = CASE WHEN available_copies > 1 THEN 0 ELSE 1 END
+            WHERE isbn = new.book_isbn AND new.is_returned = 0;
+            UPDATE members
+            SET active_loans = active_loans - (old.is_returned = 0),
+                outstanding_fines = outstanding_fines - old.fine_amount
+            WHERE id = old.member_id;
+            UPDATE members
+            SET active_loans = active_loans + (new.is_returned = 0),
+                outstanding_fines = outstanding_fines + new.fine_amount
+            WHERE id = new.member_id;
+        END;
+    )" },
+
+    // Step 6's triggers let available_copies go below zero on the way down (an active loan imported
+    // or un-returned through updateLoan) and forced status = 0 on the way up. Every trigger now keeps
+    // the counter within 0..total_copies and derives status from the new value, as reconcileCounters() does.
+    { 7, "loan counter bounds", false, R"(
+        DROP TRIGGER IF EXISTS loans_counters_insert;
+        DROP TRIGGER IF EXISTS loans_counters_delete;
+        DROP TRIGGER IF EXISTS loans_counters_update;
+
+        CREATE TRIGGER loans_counters_insert AFTER INSERT ON loans BEGIN
+            UPDATE books
+            SET available_copies = MAX(0, available_copies - 1),
+                status = CASE WHEN MAX(0, available_copies - 1) > 0 THEN 0 ELSE 1 END
+            WHERE isbn = new.book_isbn AND new.is_returned = 0;
+            UPDATE members
+            SET active_loans = active_loans + (new.is_returned = 0),
+                outstanding_fines = outstanding_fines + new.fine_amount
+            WHERE id = new.member_id;
+        END;
+        CREATE TRIGGER loans_counters_delete AFTER DELETE ON loans BEGIN
+            UPDATE books
+            SET available_copies = MIN(total_copies, available_copies + 1),
+                status = CASE WHEN MIN(total_copies, available_copies + 1) > 0 THEN 0 ELSE 1 END
+            WHERE isbn = old.book_isbn AND old.is_returned = 0;
+            UPDATE members
+            SET active_loans = active_loans - (old.is_returned = 0),
+                outstanding_fines = outstanding_fines - old.fine_amount
+            WHERE id = old.member_id;
+        END;
+        CREATE TRIGGER loans_counters_update AFTER UPDATE OF book_isbn, member_id, is_returned, fine_amount ON loans BEGIN
+            UPDATE books
+            SET available_copies = MIN(total_copies, available_copies + 1),
+                status = CASE WHEN MIN(total_copies, available_copies + 1) > 0 THEN 0 ELSE 1 END
+            WHERE isbn = old.book_isbn AND old.is_returned = 0;
+            UPDATE books
+            SET available_copies = MAX(0, available_copies - 1),
+                status = CASE WHEN MAX(0, available_copies - 1) > 0 THEN 0 ELSE 1 END
+            WHERE isbn = new.book_isbn AND new.is_returned = 0;
+            UPDATE members
+            SET active_loans = active_loans - (old.is_returned = 0),
+                outstanding_fines = outstanding_fines - old.fine_amount
+            WHERE id = old.member_id;
+            UPDATE members
+            SET active_loans = active_loans + (new.is_returned = 0),
+                outstanding_fines = outstanding_fines + new.fine_amount
+            WHERE id = new.member_id;
+        END;
+    )" },
+};
+
+const std::vector<Migration>& schemaMigrations() {
+    return MIGRATIONS;
+}
+
+int requiredSchemaVersion() {
+    int version = 0;
+    for (const auto& migration : MIGRATIONS) {
+        if (!migration.background) version = migration.version;
+    }
+    return version;
+}
+
+int latestSchemaVersion() {
+    return MIGRATIONS.empty() ? 0 : MIGRATIONS.back().version;
+}
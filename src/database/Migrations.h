@@ -0,0 +1,21 @@
+#pragma once
+#include <vector>
+
+// One step of the schema history. Steps are applied in version order and each one commits together
+// with its version record, so a database that is already current opens without writing. user_version
+// is the last step with every earlier step applied; a required step that lands while a background
+// step before it is still pending is listed in the schema_steps table until the gap closes.
+struct Migration {
+    int version;
+    const char* description;
+    bool background;   // only builds indexes: the app works without it, so it may run after the UI is up.
+                       // Required steps must not depend on one.
+    const char* sql;
+};
+
+// Never edit or reorder a released step; append a new one instead.
+const std::vector<Migration>& schemaMigrations();
+// Last step the app cannot run without. Opening applies the required steps up to it and leaves the
+// background ones to DatabaseManager::runPendingMigrations().
+int requiredSchemaVersion();
+int latestSchemaVersion();
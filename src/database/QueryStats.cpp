@@ -0,0 +1,115 @@
+#include "QueryStats.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+
+static const char* const METHOD_NAMES[] = {
+    "initialize", "schemaVersion", "migrationsPending", "runPendingMigrations", "validateLogin",
+    "addBook", "updateBook", "deleteBook", "getAllBooks", "openBookCursor", "forEachBook", "getBooksPage", "countBooks",
+    "findBook", "searchBooks", "getBookList", "getBookListPage", "searchBookList", "rebuildSearchIndex",
+    "addMember", "updateMember", "deleteMember", "getAllMembers", "openMemberCursor", "forEachMember", "getMembersPage",
+    "countMembers", "findMember", "getMemberList",
+    "checkout", "checkoutBatch", "addLoan", "updateLoan", "returnBatch", "groupCommit", "getAllLoans", "getAllLoansParallel",
+    "openLoanCursor", "forEachLoan", "getLoansPage", "countLoans", "getActiveLoans", "getLoanViewsPage", "getActiveLoanViews", "getOverdueLoans",
+    "countActiveLoans", "getMemberLoanCounts", "getMemberLoanCounts (all)", "countCopiesOut", "getMemberTypeTotals",
+    "getLibrarySummary", "getFineReport", "getCirculationReport", "reconcileCounters",
+    "backupTo", "snapshotInto", "checkQueryPlans", "explainHotQueries", "updateStatistics", "getDataVersion", "getStatementCacheStats",
+};
+static_assert(sizeof(METHOD_NAMES) / sizeof(METHOD_NAMES[0]) == static_cast<std::size_t>(DbMethod::Count),
+              "METHOD_NAMES must name every DbMethod");
+
+void QueryStats::record(DbMethod method, std::chrono::nanoseconds elapsed, std::uint64_t rows) {
+    Slot& slot = slots[static_cast<int>(method)];
+    std::uint64_t nanos = elapsed.count() > 0 ? static_cast<std::uint64_t>(elapsed.count()) : 0;
+    std::uint64_t micros = nanos / 1000;
+    int bucket = micros == 0 ? 0 : std::min(BUCKETS - 1, static_cast<int>(std::bit_width(micros)) - 1);
+
+    slot.calls.fetch_add(1, std::memory_order_relaxed);
+    slot.rows.fetch_add(rows, std::memory_order_relaxed);
+    slot.totalNanos.fetch_add(nanos, std::memory_order_relaxed);
+    slot.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    std::uint64_t seen = slot.maxNanos.load(std::memory_order_relaxed);
+    while (nanos > seen && !slot.maxNanos.compare_exchange_weak(seen, nanos, std::memory_order_relaxed)) {
+    }
+}
+
+void QueryStats::reset() {
+    for (Slot& slot : slots) {
+        slot.calls.store(0, std::memory_order_relaxed);
+        slot.rows.store(0, std::memory_order_relaxed);
+        slot.totalNanos.store(0, std::memory_order_relaxed);
+        slot.maxNanos.store(0, std::memory_order_relaxed);
+        for (auto& bucket : slot.buckets) bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+const char* QueryStats::methodName(DbMethod method) {
+    int index = static_cast<int>(method);
+    return index >= 0 && index < static_cast<int>(DbMethod::Count) ? METHOD_NAMES[index] : "?";
+}
+
+std::vector<MethodLatency> QueryStats::snapshot() const {
+    std::vector<MethodLatency> result;
+    for (int i = 0; i < static_cast<int>(DbMethod::Count); ++i) {
+        const Slot& slot = slots[i];
+        std::uint64_t calls = slot.calls.load(std::memory_order_relaxed);
+        if (calls == 0) continue;
+
+        std::uint64_t counts[BUCKETS];
+        std::uint64_t total = 0;
+        for (int b = 0; b < BUCKETS; ++b) {
+            counts[b] = slot.buckets[b].load(std::memory_order_relaxed);
+            total += counts[b];
+        }
+        double maxMs = slot.maxNanos.load(std::memory_order_relaxed) / 1e6;
+        auto percentile = [&](double p) {
+            std::uint64_t target = static_cast<std::uint64_t>(std::ceil(p * total));
+            std::uint64_t seen = 0;
+            for (int b = 0; b < BUCKETS; ++b) {
+                seen += counts[b];
+                if (seen >= target && seen > 0) return std::min(maxMs, std::ldexp(1.0, b + 1) / 1000.0);
+            }
+            return maxMs;
+        };
+
+        MethodLatency row;
+        row.method = static_cast<DbMethod>(i);
+        row.name = METHOD_NAMES[i];
+        row.calls = calls;
+        row.rows = slot.rows.load(std::memory_order_relaxed);
+        row.meanMs = slot.totalNanos.load(std::memory_order_relaxed) / 1e6 / calls;
+        row.p50Ms = percentile(0.50);
+        row.p99Ms = percentile(0.99);
+        row.maxMs = maxMs;
+        result.push_back(row);
+    }
+    return result;
+}
+
+bool QueryStats::dumpTo(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Could not write query statistics to " << path << std::endl;
+        return false;
+    }
+    std::time_t now = std::time(nullptr);
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
+    out << "# DatabaseManager latency, " << stamp << "\n";
+
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-28s %10s %12s %10s %10s %10s %10s\n",
+                  "method", "calls", "rows", "mean ms", "p50 ms", "p99 ms", "max ms");
+    out << line;
+    for (const auto& row : snapshot()) {
+        std::snprintf(line, sizeof(line), "%-28s %10llu %12llu %10.3f %10.3f %10.3f %10.3f\n", row.name,
+                      static_cast<unsigned long long>(row.calls), static_cast<unsigned long long>(row.rows),
+                      row.meanMs, row.p50Ms, row.p99Ms, row.maxMs);
+        out << line;
+    }
+    return static_cast<bool>(out);
+}
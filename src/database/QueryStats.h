@@ -0,0 +1,84 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Public DatabaseManager methods, in the order the diagnostics tab lists them. Keep METHOD_NAMES in
+// QueryStats.cpp in step with this list.
+enum class DbMethod {
+    Initialize = 0, SchemaVersion, MigrationsPending, RunPendingMigrations, ValidateLogin,
+    AddBook, UpdateBook, DeleteBook, GetAllBooks, OpenBookCursor, ForEachBook, GetBooksPage, CountBooks,
+    FindBook, SearchBooks, GetBookList, GetBookListPage, SearchBookList, RebuildSearchIndex,
+    AddMember, UpdateMember, DeleteMember, GetAllMembers, OpenMemberCursor, ForEachMember, GetMembersPage,
+    CountMembers, FindMember, GetMemberList,
+    Checkout, CheckoutBatch, AddLoan, UpdateLoan, ReturnBatch, GroupCommit, GetAllLoans, GetAllLoansParallel, OpenLoanCursor,
+    ForEachLoan, GetLoansPage, CountLoans, GetActiveLoans, GetLoanViewsPage, GetActiveLoanViews, GetOverdueLoans,
+    CountActiveLoans, GetMemberLoanCounts, GetAllMemberLoanCounts, CountCopiesOut, GetMemberTypeTotals,
+    GetLibrarySummary, GetFineReport, GetCirculationReport, ReconcileCounters,
+    BackupTo, SnapshotInto, CheckQueryPlans, ExplainHotQueries, UpdateStatistics, GetDataVersion, GetStatementCacheStats,
+    Count
+};
+
+// Latency summary of one method. Percentiles are the upper edge of their histogram bucket, so they
+// may read up to twice the true value (never more than the maximum).
+struct MethodLatency {
+    DbMethod method = DbMethod::Initialize;
+    const char* name = "";
+    std::uint64_t calls = 0;
+    std::uint64_t rows = 0;
+    double meanMs = 0.0;
+    double p50Ms = 0.0;
+    double p99Ms = 0.0;
+    double maxMs = 0.0;
+};
+
+// Call counts, rows and latency histograms per DatabaseManager method. Recording is a handful of
+// relaxed atomic adds, cheap enough to stay on; any thread may read a snapshot at any time.
+class QueryStats {
+public:
+    // Bucket i holds calls that took [2^i, 2^(i+1)) microseconds; the last one everything slower
+    static constexpr int BUCKETS = 26;
+
+private:
+    struct Slot {
+        std::atomic<std::uint64_t> calls{0};
+        std::atomic<std::uint64_t> rows{0};
+        std::atomic<std::uint64_t> totalNanos{0};
+        std::atomic<std::uint64_t> maxNanos{0};
+        std::array<std::atomic<std::uint64_t>, BUCKETS> buckets{};
+    };
+    std::array<Slot, static_cast<int>(DbMethod::Count)> slots;
+
+public:
+    void record(DbMethod method, std::chrono::nanoseconds elapsed, std::uint64_t rows);
+    void reset();
+
+    static const char* methodName(DbMethod method);
+    // Methods called at least once, in DbMethod order
+    std::vector<MethodLatency> snapshot() const;
+    // Plain-text table of snapshot(), for attaching to a bug report
+    bool dumpTo(const std::string& path) const;
+};
+
+// Times one call and records it when it goes out of scope. Set rows() before returning for methods
+// that read or write rows.
+class QueryTimer {
+private:
+    QueryStats& stats;
+    DbMethod method;
+    std::chrono::steady_clock::time_point start;
+    std::uint64_t rowCount = 0;
+
+public:
+    QueryTimer(QueryStats& stats, DbMethod method)
+        : stats(stats), method(method), start(std::chrono::steady_clock::now()) {}
+    ~QueryTimer() { stats.record(method, std::chrono::steady_clock::now() - start, rowCount); }
+    QueryTimer(const QueryTimer&) = delete;
+    QueryTimer& operator=(const QueryTimer&) = delete;
+
+    void rows(std::size_t count) { rowCount = count; }
+};
@@ -0,0 +1,61 @@
+#include "ReportingSnapshot.h"
+#include <algorithm>
+#include <thread>
+
+// Small steps: in rollback-journal mode every step holds the desk's connection
+static const int SNAPSHOT_PAGES_PER_STEP = 64;
+static constexpr std::chrono::milliseconds SNAPSHOT_STEP_PAUSE(2);
+
+// A failed refresh is retried after 30 s, doubling up to maxAge
+static constexpr std::chrono::seconds FIRST_RETRY_DELAY(30);
+
+ReportingSnapshot::ReportingSnapshot(DatabaseManager& live, const DatabaseWorker* desk, const std::string& path,
+                                     std::chrono::minutes maxAge)
+    : live(live), desk(desk), copy(path), worker(copy), maxAge(maxAge) {}
+
+ReportingSnapshot::~ReportingSnapshot() {
+    // Abandon a copy in progress rather than finishing a large file on the way out
+    closing = true;
+    worker.stop();
+}
+
+bool ReportingSnapshot::stale() const {
+    auto now = std::chrono::system_clock::now();
+    return !refreshing && now >= retryAt && now - takenAt > maxAge;
+}
+
+// Rollback-journal mode only: backup steps share the desk's connection, so let queued desk work go first
+void ReportingSnapshot::waitForIdleDesk() const {
+    if (!desk || live.storageOptions().walMode) return;
+    while (desk->pending() > 0 && !closing) {
+        std::this_thread::sleep_for(SNAPSHOT_STEP_PAUSE);
+    }
+}
+
+void ReportingSnapshot::refresh() {
+    if (refreshing) return;
+    refreshing = true;
+    worker.submit([this](DatabaseManager& snapshot) {
+            waitForIdleDesk();
+            auto started = std::chrono::system_clock::now();
+            bool ok = live.snapshotInto(snapshot, SNAPSHOT_PAGES_PER_STEP, SNAPSHOT_STEP_PAUSE,
+                                        [this](const BackupProgress&) {
+                                            waitForIdleDesk();
+                                            return !closing;
+                                        });
+            return ok ? started : std::chrono::system_clock::time_point{};
+        },
+        [this](std::chrono::system_clock::time_point started) {
+            refreshing = false;
+            lastFailed = started.time_since_epoch().count() == 0;
+            if (!lastFailed) {
+                takenAt = started;
+                retryDelay = std::chrono::seconds(0);
+                retryAt = {};
+                return;
+            }
+            std::chrono::seconds longest = maxAge;
+            retryDelay = retryDelay.count() == 0 ? FIRST_RETRY_DELAY : std::min(retryDelay * 2, longest);
+            retryAt = std::chrono::system_clock::now() + retryDelay;
+        });
+}
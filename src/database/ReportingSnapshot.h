@@ -0,0 +1,57 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <string>
+#include "DatabaseManager.h"
+#include "DatabaseWorker.h"
+
+// Reports run against a private copy of the library file instead of the desk's database. The copy is
+// refreshed with the same stepped backup as BackupScheduler and queried on its own worker thread, so a
+// history scan never holds the desk's connection or its locks. In WAL mode the refresh reads its own
+// snapshot of the file. In rollback-journal mode each backup step holds the desk's connection, so the
+// refresh only steps while `desk` has no queued jobs; a write that arrives mid-step still waits for
+// that one step.
+class ReportingSnapshot {
+private:
+    DatabaseManager& live;
+    const DatabaseWorker* desk;
+    DatabaseManager copy;
+    DatabaseWorker worker;
+    std::chrono::minutes maxAge;
+    std::atomic<bool> closing{false};
+    bool refreshing = false;
+    std::chrono::system_clock::time_point takenAt{};   // when the current copy was started
+    bool lastFailed = false;
+    std::chrono::seconds retryDelay{0};                // grows after each failed refresh
+    std::chrono::system_clock::time_point retryAt{};   // no automatic refresh before this
+
+    void waitForIdleDesk() const;
+
+public:
+    ReportingSnapshot(DatabaseManager& live, const DatabaseWorker* desk = nullptr,
+                      const std::string& path = "data/reporting.db",
+                      std::chrono::minutes maxAge = std::chrono::minutes(15));
+    ~ReportingSnapshot();
+    ReportingSnapshot(const ReportingSnapshot&) = delete;
+    ReportingSnapshot& operator=(const ReportingSnapshot&) = delete;
+
+    // Queues a new copy of the live database unless one is already on its way.
+    void refresh();
+    // Older than maxAge. After a failed refresh it stays false until the retry delay has passed.
+    bool stale() const;
+    bool isRefreshing() const { return refreshing; }
+    bool refreshFailed() const { return lastFailed; }
+    // Time the snapshot reflects; the epoch until the first copy is done.
+    std::chrono::system_clock::time_point getTakenAt() const { return takenAt; }
+
+    // Like DatabaseWorker::submit, but against the snapshot. A stale snapshot is refreshed first, and
+    // the report sees the fresh copy because the worker runs jobs in order.
+    template <typename Work, typename Done>
+    void submit(Work work, Done done) {
+        if (stale()) refresh();
+        worker.submit(std::move(work), std::move(done));
+    }
+
+    // Runs finished report completions; call once per frame from the UI thread.
+    void poll() { worker.poll(); }
+};
@@ -0,0 +1,62 @@
+#pragma once
+#include <iterator>
+#include <optional>
+#include <sqlite3.h>
+#include "StatementCache.h"
+#include "ConnectionPool.h"
+#include "RowMapper.h"
+
+// Forward-only cursor over a query result. Rows are decoded one at a time as the statement is stepped,
+// so a full scan runs in constant memory and can stop early. The cursor keeps its connection leased
+// until it is destroyed; on the desk connection that holds off writers from other threads, so keep
+// cursors short-lived.
+//
+//     for (Book& book : db.openBookCursor()) { ... }
+template <typename T>
+class RowCursor {
+public:
+    class iterator {
+    private:
+        RowCursor* cursor = nullptr;
+
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T*;
+        using reference = T&;
+
+        iterator() = default;
+        explicit iterator(RowCursor* cursor) : cursor(cursor) {}
+
+        T& operator*() const { return *cursor->current; }
+        T* operator->() const { return &*cursor->current; }
+        iterator& operator++() { cursor->advance(); return *this; }
+        void operator++(int) { cursor->advance(); }
+        bool operator==(std::default_sentinel_t) const { return !cursor || !cursor->current; }
+    };
+
+private:
+    ConnectionLease lease;
+    CachedStatement stmt;
+    std::optional<T> current;
+
+    void advance() {
+        if (stmt && sqlite3_step(stmt) == SQLITE_ROW) {
+            current.emplace(mapRow<T>(stmt));
+        } else {
+            current.reset();
+            stmt.release();
+        }
+    }
+
+public:
+    RowCursor(ConnectionLease&& lease, CachedStatement&& stmt)
+        : lease(std::move(lease)), stmt(std::move(stmt)) {
+        advance();
+    }
+    RowCursor(RowCursor&&) = default;
+
+    iterator begin() { return iterator(this); }
+    std::default_sentinel_t end() const { return {}; }
+};
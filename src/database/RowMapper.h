@@ -0,0 +1,219 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <sqlite3.h>
+#include "../core/Book.h"
+#include "../core/Member.h"
+#include "../core/Loan.h"
+
+// Compile-time mapping between result columns and C++ values.
+//
+// A RowMapping<T> specialisation gives T a static `make` function whose parameters are the columns of
+// T's SELECT list, in order. mapRow<T>() decodes every column straight into its parameter type and
+// moves the values into `make`, so a text column is copied exactly once, out of SQLite's buffer. A
+// parameter may itself be a mapped row, which then consumes as many columns as its own mapping:
+//
+//     template <> struct RowMapping<LoanView> {
+//         static LoanView make(Loan loan, std::string title, std::string name);
+//     };
+//
+// bindParams() binds ?1..?N the same way. Strings are bound without a copy (SQLITE_STATIC), so they
+// must outlive the step; CachedStatement clears the bindings when it is released. Temporaries are
+// rejected at compile time.
+
+using SqlTime = std::chrono::system_clock::time_point;
+
+template <typename T>
+struct RowMapping {};
+
+template <typename T, typename = void>
+struct IsMappedRow : std::false_type {};
+template <typename T>
+struct IsMappedRow<T, std::void_t<decltype(&RowMapping<T>::make)>> : std::true_type {};
+
+template <typename T>
+struct IsOptional : std::false_type {};
+template <typename T>
+struct IsOptional<std::optional<T>> : std::true_type {};
+
+template <typename F>
+struct MakeColumns;
+template <typename R, typename... Args>
+struct MakeColumns<R (*)(Args...)> {
+    using type = std::tuple<std::decay_t<Args>...>;
+};
+
+// The parameter types of RowMapping<T>::make as a tuple
+template <typename T>
+using RowColumns = typename MakeColumns<decltype(&RowMapping<T>::make)>::type;
+
+template <typename T>
+constexpr int columnWidth();
+
+template <typename Tuple, std::size_t... I>
+constexpr int tupleWidth(std::index_sequence<I...>) {
+    return (0 + ... + columnWidth<std::tuple_element_t<I, Tuple>>());
+}
+
+// Number of result columns a value of type T occupies
+template <typename T>
+constexpr int columnWidth() {
+    if constexpr (IsMappedRow<T>::value) {
+        using Columns = RowColumns<T>;
+        return tupleWidth<Columns>(std::make_index_sequence<std::tuple_size_v<Columns>>{});
+    } else {
+        return 1;
+    }
+}
+
+template <typename Tuple, std::size_t... I>
+constexpr std::array<int, sizeof...(I)> columnOffsets(std::index_sequence<I...>) {
+    std::array<int, sizeof...(I)> offsets{};
+    const int widths[] = { columnWidth<std::tuple_element_t<I, Tuple>>()..., 0 };
+    int at = 0;
+    for (std::size_t i = 0; i < sizeof...(I); ++i) {
+        offsets[i] = at;
+        at += widths[i];
+    }
+    return offsets;
+}
+
+template <typename T>
+T mapRow(sqlite3_stmt* stmt, int first = 0);
+
+template <typename T>
+T readColumn(sqlite3_stmt* stmt, int column) {
+    if constexpr (IsMappedRow<T>::value) {
+        return mapRow<T>(stmt, column);
+    } else if constexpr (IsOptional<T>::value) {
+        if (sqlite3_column_type(stmt, column) == SQLITE_NULL) return std::nullopt;
+        return readColumn<typename T::value_type>(stmt, column);
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        // The length is asked for after the text so it is the length of the UTF-8 form
+        const unsigned char* text = sqlite3_column_text(stmt, column);
+        if (!text) return std::string();
+        return std::string(reinterpret_cast<const char*>(text), static_cast<std::size_t>(sqlite3_column_bytes(stmt, column)));
+    } else if constexpr (std::is_same_v<T, SqlTime>) {
+        return SqlTime(std::chrono::seconds(sqlite3_column_int64(stmt, column)));
+    } else if constexpr (std::is_same_v<T, bool>) {
+        return sqlite3_column_int(stmt, column) != 0;
+    } else if constexpr (std::is_enum_v<T>) {
+        return static_cast<T>(sqlite3_column_int(stmt, column));
+    } else if constexpr (std::is_integral_v<T> && sizeof(T) > sizeof(int)) {
+        return static_cast<T>(sqlite3_column_int64(stmt, column));
+    } else if constexpr (std::is_integral_v<T>) {
+        return static_cast<T>(sqlite3_column_int(stmt, column));
+    } else if constexpr (std::is_floating_point_v<T>) {
+        return static_cast<T>(sqlite3_column_double(stmt, column));
+    } else {
+        static_assert(IsMappedRow<T>::value, "no column mapping for this type");
+    }
+}
+
+template <typename Tuple, std::size_t... I>
+Tuple readColumns(sqlite3_stmt* stmt, int first, std::index_sequence<I...> seq) {
+    constexpr auto offsets = columnOffsets<Tuple>(seq);
+    return Tuple{ readColumn<std::tuple_element_t<I, Tuple>>(stmt, first + offsets[I])... };
+}
+
+// Columns first.. of the current row as a tuple, for ad-hoc queries: auto [a, b] = readRow<int, int>(stmt);
+template <typename... Columns>
+std::tuple<Columns...> readRow(sqlite3_stmt* stmt, int first = 0) {
+    return readColumns<std::tuple<Columns...>>(stmt, first, std::index_sequence_for<Columns...>{});
+}
+
+// The current row, starting at column `first`, as a T built by RowMapping<T>::make
+template <typename T>
+T mapRow(sqlite3_stmt* stmt, int first) {
+    static_assert(IsMappedRow<T>::value, "RowMapping<T> has no make()");
+    using Columns = RowColumns<T>;
+    return std::apply(&RowMapping<T>::make,
+                      readColumns<Columns>(stmt, first, std::make_index_sequence<std::tuple_size_v<Columns>>{}));
+}
+
+// Steps the statement to the end, appending every row; returns the final step result (SQLITE_DONE
+// unless something failed).
+template <typename T>
+int readRows(sqlite3_stmt* stmt, std::vector<T>& rows) {
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        rows.push_back(mapRow<T>(stmt));
+    }
+    return rc;
+}
+
+template <typename T>
+int bindValue(sqlite3_stmt* stmt, int index, const T& value) {
+    if constexpr (IsOptional<T>::value) {
+        return value ? bindValue(stmt, index, *value) : sqlite3_bind_null(stmt, index);
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        return sqlite3_bind_text(stmt, index, value.data(), static_cast<int>(value.size()), SQLITE_STATIC);
+    } else if constexpr (std::is_same_v<T, SqlTime>) {
+        return sqlite3_bind_int64(stmt, index, std::chrono::duration_cast<std::chrono::seconds>(value.time_since_epoch()).count());
+    } else if constexpr (std::is_same_v<T, bool>) {
+        return sqlite3_bind_int(stmt, index, value ? 1 : 0);
+    } else if constexpr (std::is_enum_v<T>) {
+        return sqlite3_bind_int(stmt, index, static_cast<int>(value));
+    } else if constexpr (std::is_integral_v<T> && sizeof(T) > sizeof(int)) {
+        return sqlite3_bind_int64(stmt, index, static_cast<sqlite3_int64>(value));
+    } else if constexpr (std::is_integral_v<T>) {
+        return sqlite3_bind_int(stmt, index, static_cast<int>(value));
+    } else if constexpr (std::is_floating_point_v<T>) {
+        return sqlite3_bind_double(stmt, index, static_cast<double>(value));
+    } else {
+        static_assert(IsOptional<T>::value, "no parameter mapping for this type");
+        return SQLITE_MISUSE;
+    }
+}
+
+// C strings are bound without a copy as well; nullptr binds NULL
+inline int bindValue(sqlite3_stmt* stmt, int index, const char* value) {
+    return value ? sqlite3_bind_text(stmt, index, value, -1, SQLITE_STATIC) : sqlite3_bind_null(stmt, index);
+}
+
+// Bound without a copy, so a temporary would dangle before the statement is stepped
+int bindValue(sqlite3_stmt* stmt, int index, std::string&& value) = delete;
+int bindValue(sqlite3_stmt* stmt, int index, std::optional<std::string>&& value) = delete;
+
+// Binds ?1, ?2, ... in order; false if any bind failed.
+template <typename... Params>
+bool bindParams(sqlite3_stmt* stmt, Params&&... params) {
+    int index = 0;
+    bool ok = true;
+    ((ok = bindValue(stmt, ++index, std::forward<Params>(params)) == SQLITE_OK && ok), ...);
+    return ok;
+}
+
+template <>
+struct RowMapping<Book> {
+    // isbn, title, author, genre, publication_year, total_copies, available_copies, status
+    static Book make(std::string isbn, std::string title, std::string author, std::string genre,
+                     int publicationYear, int totalCopies, int availableCopies, Book::Status status) {
+        return Book(std::move(isbn), std::move(title), std::move(author), std::move(genre),
+                    publicationYear, totalCopies, availableCopies, status);
+    }
+};
+
+template <>
+struct RowMapping<Member> {
+    // id, name, email, phone, member_type, max_books_allowed
+    static Member make(int id, std::string name, std::string email, std::string phone, Member::Type type, int maxAllowed) {
+        return Member(id, std::move(name), std::move(email), std::move(phone), type, maxAllowed);
+    }
+};
+
+template <>
+struct RowMapping<Loan> {
+    // id, book_isbn, member_id, loan_date, due_date, return_date, is_returned, fine_amount
+    static Loan make(int id, std::string isbn, int memberId, SqlTime loanDate, SqlTime dueDate,
+                     std::optional<SqlTime> returnDate, bool isReturned, double fine) {
+        return Loan(id, std::move(isbn), memberId, loanDate, dueDate, returnDate.value_or(SqlTime{}), isReturned, fine);
+    }
+};
@@ -0,0 +1,125 @@
+#include "SlowQueryLog.h"
+#include <ctime>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+
+void SlowQueryLog::setFile(const std::string& logPath, std::uintmax_t rotateAtBytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file.is_open()) file.close();
+    path = logPath;
+    maxFileBytes = rotateAtBytes;
+}
+
+void SlowQueryLog::setThreshold(std::chrono::milliseconds threshold) {
+    std::int64_t nanos = threshold.count() > 0 ? std::chrono::duration_cast<std::chrono::nanoseconds>(threshold).count() : 0;
+    thresholdNanos.store(nanos, std::memory_order_relaxed);
+}
+
+std::chrono::milliseconds SlowQueryLog::threshold() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::nanoseconds(thresholdNanos.load(std::memory_order_relaxed)));
+}
+
+void SlowQueryLog::attach(sqlite3* db) {
+    if (db) sqlite3_trace_v2(db, SQLITE_TRACE_PROFILE, &SlowQueryLog::onTrace, this);
+}
+
+void SlowQueryLog::detach(sqlite3* db) {
+    if (db) sqlite3_trace_v2(db, 0, nullptr, nullptr);
+}
+
+int SlowQueryLog::onTrace(unsigned type, void* self, void* stmt, void* nanos) {
+    if (type == SQLITE_TRACE_PROFILE) {
+        static_cast<SlowQueryLog*>(self)->record(static_cast<sqlite3_stmt*>(stmt), *static_cast<sqlite3_int64*>(nanos));
+    }
+    return 0;
+}
+
+void SlowQueryLog::record(sqlite3_stmt* stmt, std::int64_t nanos) {
+    // The counters are cumulative per statement, and cached statements are reused, so every traced run
+    // clears them for the next one whether or not it was slow.
+    int vmSteps = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_VM_STEP, 1);
+    int fullScanSteps = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_FULLSCAN_STEP, 1);
+    int sorts = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_SORT, 1);
+    int autoIndexRows = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_AUTOINDEX, 1);
+
+    std::int64_t threshold = thresholdNanos.load(std::memory_order_relaxed);
+    if (threshold <= 0 || nanos < threshold) return;
+
+    SlowQuery entry;
+    entry.finishedAt = std::chrono::system_clock::now();
+    entry.ms = nanos / 1e6;
+    entry.vmSteps = vmSteps;
+    entry.fullScanSteps = fullScanSteps;
+    entry.sorts = sorts;
+    entry.autoIndexRows = autoIndexRows;
+    if (char* expanded = sqlite3_expanded_sql(stmt)) {
+        entry.sql = expanded;
+        sqlite3_free(expanded);
+    } else if (const char* sql = sqlite3_sql(stmt)) {
+        entry.sql = sql;
+    }
+    if (entry.sql.size() > MAX_SQL_LENGTH) {
+        entry.sql.resize(MAX_SQL_LENGTH);
+        entry.sql += "...";
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    ++total;
+    write(entry);
+    recentEntries.push_front(std::move(entry));
+    if (recentEntries.size() > RECENT_ENTRIES) recentEntries.pop_back();
+}
+
+// Called with the mutex held
+void SlowQueryLog::write(const SlowQuery& entry) {
+    if (path.empty()) return;
+
+    std::time_t t = std::chrono::system_clock::to_time_t(entry.finishedAt);
+    std::tm tm;
+#ifdef _WIN32
+    localtime_s(&tm, &t);
+#else
+    localtime_r(&t, &tm);
+#endif
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm);
+    std::ostringstream line;
+    line << stamp << " " << entry.ms << " ms, vm steps " << entry.vmSteps << ", full scan steps " << entry.fullScanSteps
+         << ", sorts " << entry.sorts << ", autoindex rows " << entry.autoIndexRows << "\n    " << entry.sql << "\n";
+
+    std::error_code error;
+    if (!file.is_open()) {
+        fileBytes = std::filesystem::file_size(path, error);
+        if (error) fileBytes = 0;
+    }
+    if (fileBytes >= maxFileBytes) {
+        file.close();
+        std::filesystem::rename(path, path + ".1", error);
+        fileBytes = 0;
+    }
+    if (!file.is_open()) {
+        file.open(path, std::ios::app);
+        if (!file) {
+            std::cerr << "Could not open the slow-query log " << path << std::endl;
+            path.clear();
+            return;
+        }
+    }
+
+    std::string text = line.str();
+    file << text;
+    file.flush();
+    fileBytes += text.size();
+}
+
+std::vector<SlowQuery> SlowQueryLog::recent() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return std::vector<SlowQuery>(recentEntries.begin(), recentEntries.end());
+}
+
+std::uint64_t SlowQueryLog::count() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return total;
+}
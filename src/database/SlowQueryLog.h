@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <sqlite3.h>
+
+// One statement that ran longer than the threshold. The step counts come from sqlite3_stmt_status
+// and cover this execution only.
+struct SlowQuery {
+    std::chrono::system_clock::time_point finishedAt;
+    double ms = 0.0;
+    std::string sql;            // with the bound values filled in
+    int vmSteps = 0;            // virtual machine operations
+    int fullScanSteps = 0;      // rows stepped through by full table scans
+    int sorts = 0;
+    int autoIndexRows = 0;      // rows put into automatic (unplanned) indexes
+};
+
+// Slow-query log fed by sqlite3_trace_v2 profile events. A connection only pays for tracing while it
+// is attached; detached connections carry no callback at all. Entries go to a text file that is
+// rotated once it passes `maxFileBytes` (the previous file keeps a ".1" suffix), and the latest few
+// stay in memory for the diagnostics tab.
+class SlowQueryLog {
+private:
+    static constexpr std::size_t RECENT_ENTRIES = 100;
+    static constexpr std::size_t MAX_SQL_LENGTH = 4000;
+
+    std::atomic<std::int64_t> thresholdNanos{0};
+    std::string path;                     // empty keeps entries in memory only
+    std::uintmax_t maxFileBytes = 1024 * 1024;
+    std::uintmax_t fileBytes = 0;
+    mutable std::mutex mutex;
+    std::ofstream file;
+    std::deque<SlowQuery> recentEntries;
+    std::uint64_t total = 0;
+
+    static int onTrace(unsigned type, void* self, void* stmt, void* nanos);
+    void record(sqlite3_stmt* stmt, std::int64_t nanos);
+    void write(const SlowQuery& entry);
+
+public:
+    SlowQueryLog() = default;
+    SlowQueryLog(const SlowQueryLog&) = delete;
+    SlowQueryLog& operator=(const SlowQueryLog&) = delete;
+
+    void setFile(const std::string& logPath, std::uintmax_t rotateAtBytes = 1024 * 1024);
+    void setThreshold(std::chrono::milliseconds threshold);
+    std::chrono::milliseconds threshold() const;
+    bool enabled() const { return thresholdNanos.load(std::memory_order_relaxed) > 0; }
+
+    // Installs or removes the profile callback on one connection
+    void attach(sqlite3* db);
+    static void detach(sqlite3* db);
+
+    // Newest first
+    std::vector<SlowQuery> recent() const;
+    std::uint64_t count() const;
+    const std::string& filePath() const { return path; }
+};
@@ -0,0 +1,67 @@
+#include "StatementCache.h"
+#include <utility>
+
+CachedStatement::CachedStatement(CachedStatement&& other) noexcept
+    : stmt(std::exchange(other.stmt, nullptr)), owned(other.owned) {}
+
+CachedStatement& CachedStatement::operator=(CachedStatement&& other) noexcept {
+    if (this != &other) {
+        release();
+        stmt = std::exchange(other.stmt, nullptr);
+        owned = other.owned;
+    }
+    return *this;
+}
+
+void CachedStatement::release() {
+    if (!stmt) return;
+    if (owned) {
+        sqlite3_finalize(stmt);
+    } else {
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+    }
+    stmt = nullptr;
+}
+
+void StatementCache::attach(sqlite3* connection) {
+    clear();
+    db = connection;
+}
+
+void StatementCache::clear() {
+    for (auto& entry : statements) {
+        sqlite3_finalize(entry.second);
+    }
+    statements.clear();
+}
+
+CachedStatement StatementCache::acquire(const char* sql) {
+    if (!db) return {};
+
+    auto it = statements.find(sql);
+    if (it != statements.end() && !sqlite3_stmt_busy(it->second)) {
+        ++stats.hits;
+        return CachedStatement(it->second, false);
+    }
+
+    ++stats.misses;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v3(db, sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK) {
+        sqlite3_finalize(stmt);
+        return {};
+    }
+
+    if (it != statements.end()) {
+        // Cached copy is busy (re-entrant use): hand out a one-off statement.
+        return CachedStatement(stmt, true);
+    }
+    statements.emplace(sql, stmt);
+    return CachedStatement(stmt, false);
+}
+
+StatementCacheStats StatementCache::getStats() const {
+    StatementCacheStats result = stats;
+    result.cached = statements.size();
+    return result;
+}
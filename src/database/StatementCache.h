@@ -0,0 +1,58 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <unordered_map>
+#include <sqlite3.h>
+
+struct StatementCacheStats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::size_t cached = 0;
+};
+
+// Handle to a statement borrowed from a StatementCache. On release the statement is reset and its
+// bindings cleared so the next caller can rebind it; one-off statements are finalized instead.
+class CachedStatement {
+private:
+    sqlite3_stmt* stmt = nullptr;
+    bool owned = false;
+
+public:
+    CachedStatement() = default;
+    CachedStatement(sqlite3_stmt* stmt, bool owned) : stmt(stmt), owned(owned) {}
+    CachedStatement(CachedStatement&& other) noexcept;
+    CachedStatement& operator=(CachedStatement&& other) noexcept;
+    CachedStatement(const CachedStatement&) = delete;
+    CachedStatement& operator=(const CachedStatement&) = delete;
+    ~CachedStatement() { release(); }
+
+    sqlite3_stmt* get() const { return stmt; }
+    operator sqlite3_stmt*() const { return stmt; }
+    explicit operator bool() const { return stmt != nullptr; }
+
+    void release();
+};
+
+// Per-connection cache of prepared statements keyed by SQL text. Each statement is prepared once and
+// then reset and rebound on every use.
+class StatementCache {
+private:
+    sqlite3* db = nullptr;
+    std::unordered_map<std::string, sqlite3_stmt*> statements;
+    StatementCacheStats stats;
+
+public:
+    StatementCache() = default;
+    ~StatementCache() { clear(); }
+    StatementCache(const StatementCache&) = delete;
+    StatementCache& operator=(const StatementCache&) = delete;
+
+    void attach(sqlite3* connection);
+    void clear();
+
+    // Returns an empty handle if the statement could not be prepared. If the cached statement is still
+    // in use further up the stack, a one-off statement is prepared so nested callers do not clobber it.
+    CachedStatement acquire(const char* sql);
+
+    StatementCacheStats getStats() const;
+};
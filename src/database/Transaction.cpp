@@ -0,0 +1,43 @@
+#include "Transaction.h"
+#include <iostream>
+
+static bool exec(sqlite3* db, const char* sql) {
+    char* err = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &err) != SQLITE_OK) {
+        std::cerr << "SQLite exec failed: " << (err ? err : "unknown") << " (" << sql << ")" << std::endl;
+        if (err) sqlite3_free(err);
+        return false;
+    }
+    return true;
+}
+
+Transaction::Transaction(sqlite3* db) : db(db) {
+    nested = sqlite3_get_autocommit(db) == 0;
+    active = exec(db, nested ? "SAVEPOINT nested_write;" : "BEGIN IMMEDIATE;");
+}
+
+Transaction::~Transaction() {
+    rollback();
+}
+
+bool Transaction::commit() {
+    if (!active) return false;
+    active = false;
+    if (exec(db, nested ? "RELEASE nested_write;" : "COMMIT;")) return true;
+
+    // A failed COMMIT (e.g. SQLITE_BUSY on the journal) leaves the transaction open
+    if (!nested && sqlite3_get_autocommit(db) == 0) exec(db, "ROLLBACK;");
+    return false;
+}
+
+void Transaction::rollback() {
+    if (!active) return;
+    active = false;
+    if (nested) {
+        exec(db, "ROLLBACK TO nested_write;");
+        exec(db, "RELEASE nested_write;");
+    } else if (sqlite3_get_autocommit(db) == 0) {
+        // SQLite may already have rolled back on its own after an I/O or full-disk error
+        exec(db, "ROLLBACK;");
+    }
+}
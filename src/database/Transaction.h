@@ -0,0 +1,24 @@
+#pragma once
+#include <sqlite3.h>
+
+// Scoped write transaction. At the top level it starts with BEGIN IMMEDIATE, which takes the write
+// lock up front so a transaction that has already read never fails later with SQLITE_BUSY when it
+// upgrades. Inside another transaction it becomes a savepoint, so helpers compose. Anything not
+// committed is rolled back when the object goes out of scope.
+class Transaction {
+private:
+    sqlite3* db;
+    bool nested = false;
+    bool active = false;
+
+public:
+    explicit Transaction(sqlite3* db);
+    ~Transaction();
+    Transaction(const Transaction&) = delete;
+    Transaction& operator=(const Transaction&) = delete;
+
+    explicit operator bool() const { return active; }
+
+    bool commit();
+    void rollback();
+};
@@ -2,7 +2,8 @@
 #include "Application.h"
 #include "LoginWindow.h"
 
-Application::Application() : dbManager("data/library.db"), window(nullptr), clearColor(ImVec4(0.95f, 0.95f, 0.95f, 1.0f)) {}
+Application::Application(const StorageOptions& storage)
+    : dbManager("data/library.db"), window(nullptr), mainWindow(storage), clearColor(ImVec4(0.95f, 0.95f, 0.95f, 1.0f)) {}
 
 Application::~Application() {
     shutdown();
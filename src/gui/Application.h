@@ -19,7 +19,7 @@ private:
     void processInput();
 
 public:
-    Application();
+    explicit Application(const StorageOptions& storage = StorageOptions());
     ~Application();
     
     bool initialize();
@@ -1,12 +1,19 @@
 #include <cstring>
+#include <algorithm>
 #include "BookManager.h"
 #include "imgui.h"
 
-BookManager::BookManager(DatabaseManager& db) : dbManager(db) {}
+BookManager::BookManager(DatabaseWorker& worker)
+    : worker(worker),
+      pagedBooks(worker,
+                 [this](const std::optional<BookPageKey>& after, int limit) {
+                     return [after, limit, sort = sortColumn](DatabaseManager& db) { return db.getBookListPage(after, limit, sort); };
+                 },
+                 [this](const BookListItem& book) { return DatabaseManager::bookPageKey(book, sortColumn); }) {}
 
 void BookManager::render() {
-    loadBooks();
     renderSearchBar();
+    refreshBooks();
     
     ImGui::Separator();
     
@@ -21,27 +28,15 @@ void BookManager::render() {
     }
     
     ImGui::SameLine();
-    if (ImGui::Button("Редагувати") && selectedBookIndex >= 0) {
-        showEditBookPopup = true;
-        const auto& book = books[selectedBookIndex];
-        
-        strncpy(isbnBuffer, book.getISBN().c_str(), sizeof(isbnBuffer) - 1);
-        strncpy(titleBuffer, book.getTitle().c_str(), sizeof(titleBuffer) - 1);
-        strncpy(authorBuffer, book.getAuthor().c_str(), sizeof(authorBuffer) - 1);
-        strncpy(genreBuffer, book.getGenre().c_str(), sizeof(genreBuffer) - 1);
-        
-        isbnBuffer[sizeof(isbnBuffer) - 1] = '\0';
-        titleBuffer[sizeof(titleBuffer) - 1] = '\0';
-        authorBuffer[sizeof(authorBuffer) - 1] = '\0';
-        genreBuffer[sizeof(genreBuffer) - 1] = '\0';
-        
-        publicationYear = book.getPublicationYear();
-        totalCopies = book.getTotalCopies();
+    ImGui::BeginDisabled(fetchingBook);
+    if (ImGui::Button("Редагувати") && selectedBook) {
+        openEditor(selectedBook->isbn);
     }
+    ImGui::EndDisabled();
     
     ImGui::SameLine();
-    if (ImGui::Button("Видалити") && selectedBookIndex >= 0) {
-        deleteBook(selectedBookIndex);
+    if (ImGui::Button("Видалити") && selectedBook) {
+        deleteBook(selectedBook->isbn);
     }
     
     ImGui::Spacing();
@@ -62,45 +57,79 @@ void BookManager::renderSearchBar() {
     ImGui::SameLine();
     ImGui::SetNextItemWidth(400);   
     ImGui::InputText("##search", searchBuffer, sizeof(searchBuffer));
-    if (strlen(searchBuffer) > 0) {
-        searchBooks(searchBuffer);
+
+    if (loading || pagedBooks.loading()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("Завантаження...");
     }
 }
 
 void BookManager::renderBookList() {
     if (ImGui::BeginTable("BooksTable", 6, 
-        ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY))
+        ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_Sortable))
     {
-        ImGui::TableSetupColumn("ISBN");
-        ImGui::TableSetupColumn("Назва");
-        ImGui::TableSetupColumn("Автор");
-        ImGui::TableSetupColumn("Рік");
-        ImGui::TableSetupColumn("Доступно");
-        ImGui::TableSetupColumn("Статус");
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("ISBN", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_NoSortDescending);
+        ImGui::TableSetupColumn("Назва", ImGuiTableColumnFlags_NoSortDescending);
+        ImGui::TableSetupColumn("Автор", ImGuiTableColumnFlags_NoSortDescending);
+        ImGui::TableSetupColumn("Рік", ImGuiTableColumnFlags_NoSort);
+        ImGui::TableSetupColumn("Доступно", ImGuiTableColumnFlags_NoSort);
+        ImGui::TableSetupColumn("Статус", ImGuiTableColumnFlags_NoSort);
         ImGui::TableHeadersRow();
 
-        for (int i = 0; i < static_cast<int>(books.size()); i++) {
-            const auto& book = books[i];
-
-            ImGui::TableNextRow();
-
-            // Вся рядок клікабельна через Selectable
-            ImGui::TableSetColumnIndex(0);
-            if (ImGui::Selectable(book.getISBN().c_str(), selectedBookIndex == i, ImGuiSelectableFlags_SpanAllColumns)) {
-                selectedBookIndex = i;
+        // Sorting is done by the keyset query, so a new sort column just restarts the pages
+        if (ImGuiTableSortSpecs* sortSpecs = ImGui::TableGetSortSpecs()) {
+            if (sortSpecs->SpecsDirty && sortSpecs->SpecsCount > 0) {
+                sortColumn = static_cast<BookSort>(sortSpecs->Specs[0].ColumnIndex);
+                booksLoaded = false;
+                sortSpecs->SpecsDirty = false;
             }
+        }
 
-            ImGui::TableSetColumnIndex(1); ImGui::Text("%s", book.getTitle().c_str());
-            ImGui::TableSetColumnIndex(2); ImGui::Text("%s", book.getAuthor().c_str());
-            ImGui::TableSetColumnIndex(3); ImGui::Text("%d", book.getPublicationYear());
-            ImGui::TableSetColumnIndex(4); ImGui::Text("%d/%d", book.getAvailableCopies(), book.getTotalCopies());
-            ImGui::TableSetColumnIndex(5); ImGui::Text("%s", book.getStatusString().c_str());
+        bool searching = !shownQuery.empty();
+        int rowCount = searching ? static_cast<int>(books.size()) : pagedBooks.size();
+
+        ImGuiListClipper clipper;
+        clipper.Begin(rowCount);
+        int firstVisible = rowCount, lastVisible = 0;
+        while (clipper.Step()) {
+            firstVisible = std::min(firstVisible, clipper.DisplayStart);
+            lastVisible = std::max(lastVisible, clipper.DisplayEnd);
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                const BookListItem* book = searching ? &books[i] : pagedBooks.row(i);
+                if (book) {
+                    renderBookRow(*book);
+                } else {
+                    // Page still on its way from the worker
+                    ImGui::TableNextRow();
+                    ImGui::TableSetColumnIndex(0);
+                    ImGui::TextDisabled("...");
+                }
+            }
         }
+        if (!searching) pagedBooks.trim(firstVisible, lastVisible);
 
         ImGui::EndTable();
     }
 }
 
+void BookManager::renderBookRow(const BookListItem& book) {
+    ImGui::TableNextRow();
+
+    // Вся рядок клікабельна через Selectable
+    ImGui::TableSetColumnIndex(0);
+    bool selected = selectedBook && selectedBook->isbn == book.isbn;
+    if (ImGui::Selectable(book.isbn.c_str(), selected, ImGuiSelectableFlags_SpanAllColumns)) {
+        selectedBook = book;
+    }
+
+    ImGui::TableSetColumnIndex(1); ImGui::Text("%s", book.title.c_str());
+    ImGui::TableSetColumnIndex(2); ImGui::Text("%s", book.author.c_str());
+    ImGui::TableSetColumnIndex(3); ImGui::Text("%d", book.publicationYear);
+    ImGui::TableSetColumnIndex(4); ImGui::Text("%d/%d", book.availableCopies, book.totalCopies);
+    ImGui::TableSetColumnIndex(5); ImGui::Text("%s", Book::statusToString(book.status).c_str());
+}
+
 void BookManager::renderAddBookPopup() {
     static std::string addBookError;
     static bool showAddBookError = false;
@@ -157,8 +186,8 @@ void BookManager::renderEditBookPopup() {
     static std::string editBookError;
     static bool showEditBookError = false;
 
-    if (selectedBookIndex < 0) return; 
-    Book& book = books[selectedBookIndex];
+    if (!editedBook) return;
+    const Book& book = *editedBook;
 
     if (showEditBookPopup && !ImGui::IsPopupOpen("Редагувати книгу")) {
         strncpy(isbnBuffer, book.getISBN().c_str(), sizeof(isbnBuffer));
@@ -223,71 +252,82 @@ void BookManager::renderEditBookPopup() {
 }
 
 void BookManager::addBook() {
+    // The list is refreshed from the database once the books data version moves
     Book newBook(isbnBuffer, titleBuffer, authorBuffer, genreBuffer, publicationYear, totalCopies);
-    books.push_back(newBook);
-    dbManager.addBook(newBook);
+    worker.submitWrite([newBook](DatabaseManager& db) { return db.addBook(newBook); });
+}
+
+// The list rows carry only what the table shows, so the whole record is read when the editor opens.
+void BookManager::openEditor(const std::string& isbn) {
+    fetchingBook = true;
+    worker.submit([isbn](DatabaseManager& db) { return db.findBook(isbn); },
+        [this](std::optional<Book> book) {
+            fetchingBook = false;
+            if (!book) {
+                // Deleted meanwhile
+                selectedBook.reset();
+                booksLoaded = false;
+                return;
+            }
+            editedBook = std::move(book);
+            showEditBookPopup = true;
+        });
 }
 
 void BookManager::editBook() {
-    if (selectedBookIndex >= 0 && selectedBookIndex < static_cast<int>(books.size())) {
-        auto oldBook = books[selectedBookIndex];
+    if (editedBook) {
         // Preserve original ISBN (primary key). Ignore changes to ISBN in edit dialog.
-        std::string origIsbn = oldBook.getISBN();
-
-        int newTotal = totalCopies;
-      int prevAvailable = oldBook.getAvailableCopies();
-
-        int diff = newTotal - oldBook.getTotalCopies();
-        int newAvailable = prevAvailable + diff;
-
-        if (newAvailable > newTotal) newAvailable = newTotal;
-        if (newAvailable < 0) newAvailable = 0; 
-        Book updated(origIsbn,
+        // Available copies are adjusted in the database by the change in total copies.
+        Book updated(editedBook->getISBN(),
                      std::string(titleBuffer),
                      std::string(authorBuffer),
                      std::string(genreBuffer),
                      publicationYear,
-                     newTotal,
-                     newAvailable,
-                     oldBook.getStatus());
-
-        // Persist to DB and update local cache
-        if (dbManager.updateBook(updated)) {
-            books[selectedBookIndex] = updated;
-        } else {
-            // If DB update failed, reload list to reflect DB state
-            loadBooks();
-        }
+                     totalCopies);
+
+        // The list is refreshed from the database once the books data version moves
+        worker.submitWrite([updated](DatabaseManager& db) { return db.updateBook(updated); },
+            [this](bool ok) {
+                if (!ok) {
+                    // If DB update failed, reload list to reflect DB state
+                    booksLoaded = false;
+                }
+            });
     }
 }
 
-void BookManager::deleteBook(int index) {
-    if (index >= 0 && index < static_cast<int>(books.size())) {
-        std::string isbn = books[index].getISBN();
-        books.erase(books.begin() + index);
-        dbManager.deleteBook(isbn);
-        selectedBookIndex = -1;
-    }
+void BookManager::deleteBook(const std::string& isbn) {
+    worker.submitWrite([isbn](DatabaseManager& db) { return db.deleteBook(isbn); });
+    selectedBook.reset();
 }
 
-void BookManager::loadBooks() {
-    books = dbManager.getAllBooks();
-}
+// Reload only when the books table, the search query or the sort changed since the last load. The
+// load runs on the worker; the rows already on screen stay until it completes.
+void BookManager::refreshBooks() {
+    if (loading) return;
+    DataVersion version = worker.dataVersion(DataTable::Books);
+    std::string query = searchBuffer;
+    if (booksLoaded && version == loadedVersion && query == loadedQuery) return;
+
+    loadedVersion = version;
+    loadedQuery = query;
+    booksLoaded = true;
+    loading = true;
 
-void BookManager::searchBooks(const std::string& query) {
     if (query.empty()) {
-        loadBooks();
-        return;
-    }
-    
-    std::vector<Book> allBooks = dbManager.getAllBooks();
-    books.clear();
-    
-    for (const auto& book : allBooks) {
-        if (book.getTitle().find(query) != std::string::npos ||
-            book.getAuthor().find(query) != std::string::npos ||
-            book.getISBN().find(query) != std::string::npos) {
-            books.push_back(book);
-        }
+        worker.submit([](DatabaseManager& db) { return db.countBooks(); },
+            [this](int count) {
+                books.clear();
+                pagedBooks.reset(count);
+                shownQuery.clear();
+                loading = false;
+            });
+    } else {
+        worker.submit([query](DatabaseManager& db) { return db.searchBookList(query); },
+            [this, query](std::vector<BookListItem> found) {
+                books = std::move(found);
+                shownQuery = query;
+                loading = false;
+            });
     }
 }
@@ -2,12 +2,23 @@
 #include <vector>
 #include <string>
 #include "../core/Book.h"
-#include "../database/DatabaseManager.h"
+#include "../database/DatabaseWorker.h"
+#include "PagedTable.h"
 
 class BookManager {
 private:
-    DatabaseManager& dbManager;
-    std::vector<Book> books;
+    DatabaseWorker& worker;
+    std::vector<BookListItem> books;                      // search results
+    PagedTable<BookListItem, BookPageKey> pagedBooks;     // full catalog, fetched a page at a time
+    BookSort sortColumn = BookSort::Isbn;
+    std::optional<BookListItem> selectedBook;
+    std::optional<Book> editedBook;                       // whole record, fetched when the editor opens
+    bool fetchingBook = false;
+    DataVersion loadedVersion;
+    std::string loadedQuery;                      // query of the last load submitted
+    std::string shownQuery;                       // query the rows on screen belong to
+    bool booksLoaded = false;
+    bool loading = false;
     
     char searchBuffer[256] = "";
     char isbnBuffer[64] = "";
@@ -19,22 +30,22 @@ private:
     
     bool showAddBookPopup = false;
     bool showEditBookPopup = false;
-    int selectedBookIndex = -1;
 
     void renderBookList();
+    void renderBookRow(const BookListItem& book);
     void renderAddBookPopup();
     void renderEditBookPopup();
     void renderSearchBar();
     
     void addBook();
+    void openEditor(const std::string& isbn);
     void editBook();
-    void deleteBook(int index);
-    void searchBooks(const std::string& query);
+    void deleteBook(const std::string& isbn);
+    void refreshBooks();
 
 public:
-    BookManager(DatabaseManager& db);
+    BookManager(DatabaseWorker& worker);
     
     void render();
-    void loadBooks();
     void saveBooks();
 };
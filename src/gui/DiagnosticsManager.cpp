@@ -0,0 +1,260 @@
+#include <algorithm>
+#include <ctime>
+#include <filesystem>
+#include "DiagnosticsManager.h"
+#include "imgui.h"
+
+DiagnosticsManager::DiagnosticsManager(DatabaseWorker& worker, QueryStats& stats, SlowQueryLog& slowQueries)
+    : worker(worker), stats(stats), slowQueries(slowQueries) {
+    slowLogOn = slowQueries.enabled();
+    if (slowLogOn) slowThresholdMs = static_cast<int>(slowQueries.threshold().count());
+}
+
+void DiagnosticsManager::render() {
+    if (ImGui::BeginTabBar("DiagnosticsTabs")) {
+        if (ImGui::BeginTabItem("Час виконання")) {
+            renderLatencyTab();
+            ImGui::EndTabItem();
+        }
+        if (ImGui::BeginTabItem("Повільні запити")) {
+            renderSlowQueryTab();
+            ImGui::EndTabItem();
+        }
+        if (ImGui::BeginTabItem("Плани запитів")) {
+            renderQueryPlanTab();
+            ImGui::EndTabItem();
+        }
+        ImGui::EndTabBar();
+    }
+}
+
+void DiagnosticsManager::renderLatencyTab() {
+    ImGui::Text("Час виконання запитів до бази з моменту запуску");
+    ImGui::SameLine();
+    if (ImGui::Button("Скинути")) {
+        stats.reset();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Зберегти у файл")) {
+        saveToFile();
+    }
+    if (!lastDump.empty()) {
+        if (dumpFailed) {
+            ImGui::TextColored(ImVec4(0.85f, 0.2f, 0.2f, 1.0f), "Не вдалося зберегти %s", lastDump.c_str());
+        } else {
+            ImGui::Text("Збережено: %s", lastDump.c_str());
+        }
+    }
+    ImGui::Separator();
+    renderLatencyTable();
+}
+
+void DiagnosticsManager::renderLatencyTable() {
+    // The counters are atomics, so reading them every frame from the UI thread is safe and cheap
+    std::vector<MethodLatency> rows = stats.snapshot();
+    if (rows.empty()) {
+        ImGui::TextDisabled("Запитів ще не було");
+        return;
+    }
+
+    if (ImGui::BeginTable("QueryLatency", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
+        ImGui::TableSetupColumn("Метод");
+        ImGui::TableSetupColumn("Викликів");
+        ImGui::TableSetupColumn("Рядків");
+        ImGui::TableSetupColumn("Середнє, мс");
+        ImGui::TableSetupColumn("p50, мс");
+        ImGui::TableSetupColumn("p99, мс");
+        ImGui::TableSetupColumn("Макс, мс");
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableHeadersRow();
+
+        for (const auto& row : rows) {
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0); ImGui::Text("%s", row.name);
+            ImGui::TableSetColumnIndex(1); ImGui::Text("%llu", static_cast<unsigned long long>(row.calls));
+            ImGui::TableSetColumnIndex(2); ImGui::Text("%llu", static_cast<unsigned long long>(row.rows));
+            ImGui::TableSetColumnIndex(3); ImGui::Text("%.3f", row.meanMs);
+            ImGui::TableSetColumnIndex(4); ImGui::Text("%.3f", row.p50Ms);
+            ImGui::TableSetColumnIndex(5); ImGui::Text("%.3f", row.p99Ms);
+            ImGui::TableSetColumnIndex(6); ImGui::Text("%.3f", row.maxMs);
+        }
+        ImGui::EndTable();
+    }
+}
+
+void DiagnosticsManager::saveToFile() {
+    std::time_t t = std::time(nullptr);
+    std::tm tm;
+#ifdef _WIN32
+    localtime_s(&tm, &t);
+#else
+    localtime_r(&t, &tm);
+#endif
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "%Y%m%d-%H%M%S", &tm);
+
+    std::error_code error;
+    std::filesystem::create_directories("data", error);
+    lastDump = std::string("data/query-stats-") + buf + ".txt";
+    dumpFailed = !stats.dumpTo(lastDump);
+}
+
+void DiagnosticsManager::renderSlowQueryTab() {
+    bool changed = ImGui::Checkbox("Записувати запити, довші за", &slowLogOn);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(120);
+    changed |= ImGui::InputInt("мс", &slowThresholdMs);
+    if (slowThresholdMs < 1) slowThresholdMs = 1;
+    if (changed) applySlowQueryThreshold();
+
+    if (!slowQueries.filePath().empty()) {
+        ImGui::Text("Журнал: %s", slowQueries.filePath().c_str());
+    }
+    ImGui::Text("Записано з моменту запуску: %llu", static_cast<unsigned long long>(slowQueries.count()));
+    ImGui::Separator();
+
+    std::vector<SlowQuery> entries = slowQueries.recent();
+    if (ImGui::BeginTable("SlowQueries", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
+        ImGui::TableSetupColumn("Час");
+        ImGui::TableSetupColumn("мс");
+        ImGui::TableSetupColumn("Кроків VM");
+        ImGui::TableSetupColumn("Кроків сканування");
+        ImGui::TableSetupColumn("Сортувань");
+        ImGui::TableSetupColumn("SQL", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableHeadersRow();
+
+        for (const auto& entry : entries) {
+            std::time_t t = std::chrono::system_clock::to_time_t(entry.finishedAt);
+            std::tm tm;
+#ifdef _WIN32
+            localtime_s(&tm, &t);
+#else
+            localtime_r(&t, &tm);
+#endif
+            char buf[16];
+            std::strftime(buf, sizeof(buf), "%H:%M:%S", &tm);
+
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0); ImGui::Text("%s", buf);
+            ImGui::TableSetColumnIndex(1); ImGui::Text("%.1f", entry.ms);
+            ImGui::TableSetColumnIndex(2); ImGui::Text("%d", entry.vmSteps);
+            ImGui::TableSetColumnIndex(3); ImGui::Text("%d", entry.fullScanSteps);
+            ImGui::TableSetColumnIndex(4); ImGui::Text("%d", entry.sorts);
+            ImGui::TableSetColumnIndex(5); ImGui::TextWrapped("%s", entry.sql.c_str());
+        }
+        ImGui::EndTable();
+    }
+}
+
+// Attaching the trace takes the write connection, so it waits its turn on the worker
+void DiagnosticsManager::applySlowQueryThreshold() {
+    std::chrono::milliseconds threshold(slowLogOn ? slowThresholdMs : 0);
+    worker.submit([threshold](DatabaseManager& db) { db.setSlowQueryThreshold(threshold); });
+}
+
+void DiagnosticsManager::renderQueryPlanTab() {
+    ImGui::BeginDisabled(explaining);
+    if (ImGui::Button("Перевірити плани")) {
+        explainQueries(false);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Оновити статистику і перевірити")) {
+        explainQueries(true);
+    }
+    ImGui::EndDisabled();
+    if (explaining) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("Виконується...");
+    }
+    if (plans.empty()) {
+        ImGui::TextDisabled("Плани ще не перевірялися");
+        return;
+    }
+    int regressed = 0;
+    for (const auto& report : plans) regressed += report.regressed ? 1 : 0;
+    if (regressed > 0) {
+        ImGui::TextColored(ImVec4(0.85f, 0.2f, 0.2f, 1.0f), "Запитів із погіршеним планом: %d з %d", regressed, static_cast<int>(plans.size()));
+    } else {
+        ImGui::Text("Усі %d запитів використовують індекси як задумано", static_cast<int>(plans.size()));
+    }
+    ImGui::Separator();
+
+    if (ImGui::BeginTable("QueryPlans", 8, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY,
+                          ImVec2(0, ImGui::GetContentRegionAvail().y * 0.6f))) {
+        ImGui::TableSetupColumn("Метод");
+        ImGui::TableSetupColumn("Оцінка рядків");
+        ImGui::TableSetupColumn("Фактично");
+        ImGui::TableSetupColumn("мс");
+        ImGui::TableSetupColumn("Повне сканування");
+        ImGui::TableSetupColumn("Temp B-tree");
+        ImGui::TableSetupColumn("Авто-індекс");
+        ImGui::TableSetupColumn("Стан");
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableHeadersRow();
+
+        for (int i = 0; i < static_cast<int>(plans.size()); ++i) {
+            const auto& report = plans[i];
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            ImGui::PushID(i);
+            if (ImGui::Selectable(report.name.c_str(), selectedPlan == i, ImGuiSelectableFlags_SpanAllColumns)) {
+                selectedPlan = i;
+            }
+            ImGui::PopID();
+            ImGui::TableSetColumnIndex(1);
+            if (report.estimatedRows >= 0) ImGui::Text("%lld", static_cast<long long>(report.estimatedRows));
+            else ImGui::TextDisabled("-");
+            ImGui::TableSetColumnIndex(2);
+            if (report.actualRows >= 0) ImGui::Text("%d", report.actualRows);
+            else ImGui::TextDisabled("-");
+            ImGui::TableSetColumnIndex(3); ImGui::Text("%.2f", report.ms);
+            ImGui::TableSetColumnIndex(4); ImGui::Text("%s", report.fullScan ? "так" : "");
+            ImGui::TableSetColumnIndex(5); ImGui::Text("%s", report.tempBTree ? "так" : "");
+            ImGui::TableSetColumnIndex(6); ImGui::Text("%s", report.autoIndex ? "так" : "");
+            ImGui::TableSetColumnIndex(7);
+            if (!report.error.empty()) ImGui::TextColored(ImVec4(0.85f, 0.2f, 0.2f, 1.0f), "помилка");
+            else if (report.regressed) ImGui::TextColored(ImVec4(0.85f, 0.2f, 0.2f, 1.0f), "погіршено");
+            else ImGui::Text("гаразд");
+        }
+        ImGui::EndTable();
+    }
+
+    if (selectedPlan >= 0 && selectedPlan < static_cast<int>(plans.size())) {
+        renderPlanDetails(plans[selectedPlan]);
+    }
+}
+
+void DiagnosticsManager::renderPlanDetails(const QueryPlanReport& report) {
+    ImGui::Separator();
+    ImGui::TextWrapped("%s", report.sql.c_str());
+    if (!report.error.empty()) {
+        ImGui::TextColored(ImVec4(0.85f, 0.2f, 0.2f, 1.0f), "%s", report.error.c_str());
+    }
+    for (const auto& step : report.steps) {
+        // Steps nest under their parent; depth is found by walking the parent ids
+        int depth = 0;
+        for (int parent = step.parent; parent != 0 && depth < 16; ++depth) {
+            auto it = std::find_if(report.steps.begin(), report.steps.end(), [&](const QueryPlanStep& s) { return s.id == parent; });
+            parent = it == report.steps.end() ? 0 : it->parent;
+        }
+        ImGui::Indent(16.0f * (depth + 1));
+        if (step.estimatedRows >= 0) ImGui::Text("%s  (~%lld рядків)", step.detail.c_str(), static_cast<long long>(step.estimatedRows));
+        else ImGui::Text("%s", step.detail.c_str());
+        ImGui::Unindent(16.0f * (depth + 1));
+    }
+}
+
+// Runs the plans and the sample queries on the worker; they use the desk's database like any other read
+void DiagnosticsManager::explainQueries(bool analyzeFirst) {
+    explaining = true;
+    worker.submit([analyzeFirst](DatabaseManager& db) {
+            if (analyzeFirst) db.updateStatistics();
+            return db.explainHotQueries(true);
+        },
+        [this](std::vector<QueryPlanReport> reports) {
+            plans = std::move(reports);
+            if (selectedPlan >= static_cast<int>(plans.size())) selectedPlan = -1;
+            explaining = false;
+        });
+}
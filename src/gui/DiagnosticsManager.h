@@ -0,0 +1,32 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "../database/DatabaseWorker.h"
+
+class DiagnosticsManager {
+private:
+    DatabaseWorker& worker;
+    QueryStats& stats;
+    SlowQueryLog& slowQueries;
+    std::string lastDump;    // file written by the last "save", or the error
+    bool dumpFailed = false;
+    bool slowLogOn = false;
+    int slowThresholdMs = 100;
+    std::vector<QueryPlanReport> plans;
+    int selectedPlan = -1;
+    bool explaining = false;
+
+    void renderLatencyTab();
+    void renderLatencyTable();
+    void renderSlowQueryTab();
+    void applySlowQueryThreshold();
+    void renderQueryPlanTab();
+    void renderPlanDetails(const QueryPlanReport& report);
+    void explainQueries(bool analyzeFirst);
+    void saveToFile();
+
+public:
+    DiagnosticsManager(DatabaseWorker& worker, QueryStats& stats, SlowQueryLog& slowQueries);
+
+    void render();
+};
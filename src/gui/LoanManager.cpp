@@ -3,29 +3,34 @@
 #include "imgui.h"
 #include <algorithm>
 
-LoanManager::LoanManager(DatabaseManager& db) : dbManager(db) {
+LoanManager::LoanManager(DatabaseWorker& worker)
+    : worker(worker),
+      pagedLoans(worker,
+                 [](const std::optional<LoanPageKey>& after, int limit) {
+                     return [after, limit](DatabaseManager& db) { return db.getLoanViewsPage(after, limit, LoanSort::Id); };
+                 },
+                 [](const LoanView& view) { return DatabaseManager::loanPageKey(view.loan, LoanSort::Id); }) {
     loadData();
 }
 
 void LoanManager::render() {
     if (ImGui::BeginTabBar("LoanTabs")) {
         if (ImGui::BeginTabItem("Позичити книгу")) {
-            // Refresh data when opening the borrow tab so we always show current books/members
-            loadData();
+            // Refresh data when the books/members shown here changed
+            refreshData();
             renderBorrowSection();
             ImGui::EndTabItem();
         }
 
         if (ImGui::BeginTabItem("Повернути книгу")) {
-            // Refresh active loans/books before showing return UI
-            loadData(); 
+            refreshData();
             renderReturnSection();
             ImGui::EndTabItem();
         }
 
         if (ImGui::BeginTabItem("Список позичень")) {
-            // Ensure the list of loans is current
-            loadData();
+            refreshData();
+            renderSummary();
             renderLoanList();
             ImGui::EndTabItem();
         }
@@ -47,50 +52,97 @@ void LoanManager::render() {
 
 }
 
-bool LoanManager::maxBooksAllowedExceeded(const Member& member) const {
-    int activeLoans = 0;
-    for (const auto& loan : loans) {
-        if (loan.getMemberId() == member.getId() && !loan.getIsReturned()) {
-            ++activeLoans;
-        }
+static const char* checkoutMessage(CheckoutResult result) {
+    switch (result) {
+        case CheckoutResult::Ok: return "позичено";
+        case CheckoutResult::BookNotFound: return "Книгу не знайдено, можливо її видалено.";
+        case CheckoutResult::NoCopiesAvailable: return "Усі примірники цієї книги вже видано!";
+        case CheckoutResult::MemberNotFound: return "Читача не знайдено, можливо його видалено.";
+        case CheckoutResult::LimitReached: return "Читач досяг ліміту книг.";
+        case CheckoutResult::Failed: break;
     }
-    return activeLoans >= member.getMaxBooksAllowed();
+    return "Не вдалося зберегти позичку. Спробуйте ще раз.";
 }
 
 void LoanManager::addLoan() {
     if (selectedBookIndex < 0 || selectedMemberIndex < 0) return;
 
-    Book& book = books[selectedBookIndex];
-    Member& member = members[selectedMemberIndex];
-
-    if (!book.isAvailable() || maxBooksAllowedExceeded(member)) {
-        ImGui::OpenPopup("ЛімітКниг");
-        return;
-    }
-
+    const BookListItem& book = borrowBooks()[selectedBookIndex];
+    const MemberListItem& member = members[selectedMemberIndex];
 
     // Create Loan with placeholder id (DB will assign id via AUTOINCREMENT)
-    Loan newLoan(0, book.getISBN(), member.getId(), loanDays);
+    Loan newLoan(0, book.isbn, member.id, loanDays);
+
+    // The checkout decides eligibility against the current rows, not this frame's cached copies
+    ++writesInFlight;
+    worker.submitWrite([newLoan](DatabaseManager& db) { return db.checkout(newLoan); },
+        [this](CheckoutResult result) {
+            --writesInFlight;
+            switch (result) {
+                case CheckoutResult::Ok:
+                    // Local cache is refreshed once the loans data version has moved
+                    selectedBookIndex = -1;
+                    selectedMemberIndex = -1;
+                    borrowPopup = "Позичка успішна";
+                    return;
+                case CheckoutResult::LimitReached:
+                    borrowPopup = "ЛімітКниг";
+                    return;
+                default:
+                    checkoutError = checkoutMessage(result);
+                    borrowPopup = "ВідмоваПозички";
+                    return;
+            }
+        });
+}
 
-    // Let DatabaseManager handle transactional changes (it will decrement available_copies)
-    if (dbManager.addLoan(newLoan)) {
-        // Refresh local cache after DB change
-        loadData();
-        selectedBookIndex = -1;
-        selectedMemberIndex = -1;
-        ImGui::OpenPopup("Позичка успішна");
-    } else {
-        ImGui::OpenPopup("Помилка"); // existing "Помилка" popup handles messaging
-    }
+// Submits every queued book for the selected member in one transaction. Refused books stay in the
+// basket so the librarian can see what is left.
+void LoanManager::checkoutBasket() {
+    if (basket.empty() || selectedMemberIndex < 0) return;
+
+    std::vector<std::string> isbns;
+    isbns.reserve(basket.size());
+    for (const auto& book : basket) isbns.push_back(book.isbn);
+
+    ++writesInFlight;
+    worker.submit([memberId = members[selectedMemberIndex].id, isbns, days = loanDays](DatabaseManager& db) {
+            return db.checkoutBatch(memberId, isbns, days);
+        },
+        [this, submitted = basket](std::vector<CheckoutResult> results) {
+            --writesInFlight;
+            basketReport.clear();
+            std::vector<BookListItem> refused;
+            for (size_t i = 0; i < submitted.size(); ++i) {
+                basketReport.push_back(submitted[i].title + " - " + checkoutMessage(results[i]));
+                if (results[i] != CheckoutResult::Ok) refused.push_back(submitted[i]);
+            }
+            // Keep anything queued while the batch was running
+            for (const auto& book : basket) {
+                bool wasSubmitted = std::any_of(submitted.begin(), submitted.end(),
+                                                [&](const BookListItem& b) { return b.isbn == book.isbn; });
+                if (!wasSubmitted) refused.push_back(book);
+            }
+            basket = std::move(refused);
+            if (basket.empty()) selectedMemberIndex = -1;
+            borrowPopup = "РезультатКошика";
+        });
 }
 
 void LoanManager::renderBorrowSection() {
+    // Results of checkouts arrive between frames; their popups have to open inside this tab
+    if (borrowPopup) {
+        ImGui::OpenPopup(borrowPopup);
+        borrowPopup = nullptr;
+    }
 
     // --- ПОШУК І ДНІ ПОЗИКИ ---
     ImGui::Text("Пошук книги:");
     ImGui::SameLine();
     ImGui::SetNextItemWidth(300);
-    ImGui::InputText("##bookSearch", searchBuffer, sizeof(searchBuffer));
+    if (ImGui::InputText("##bookSearch", searchBuffer, sizeof(searchBuffer))) {
+        searchBorrowBooks();
+    }
 
     ImGui::SameLine();
     ImGui::SetNextItemWidth(120);
@@ -101,7 +153,11 @@ void LoanManager::renderBorrowSection() {
     loanDays = std::clamp(loanDays, MIN_DAYS, MAX_DAYS);
 
     // --- КНОПКА ПОЗИЧЕННЯ ---
-    if (ImGui::Button("Позичити книгу")) {
+    // Disabled while a checkout is still on the worker, so a double click cannot submit twice
+    ImGui::BeginDisabled(writesInFlight > 0);
+    bool borrowClicked = ImGui::Button("Позичити книгу");
+    ImGui::EndDisabled();
+    if (borrowClicked) {
 
         // 1. Перевірка: чи вибрана книга і чи вибраний читач
         if (selectedBookIndex < 0 || selectedMemberIndex < 0) {
@@ -109,17 +165,46 @@ void LoanManager::renderBorrowSection() {
             return;
         }
 
-        Book& book = books[selectedBookIndex];
-        Member& member = members[selectedMemberIndex];
+        // 2. Додаємо позичку; ліміт і наявність примірників перевіряє база
+        addLoan();
+    }
 
-        // 2. Перевірка: ліміт або недоступність книги
-        if (!book.isAvailable() || maxBooksAllowedExceeded(member)) {
-            ImGui::OpenPopup("ЛімітКниг");
-            return;
-        }
+    // --- КОШИК: кілька книг одним підтвердженням ---
+    ImGui::SameLine();
+    if (ImGui::Button("До кошика") && selectedBookIndex >= 0) {
+        const BookListItem& book = borrowBooks()[selectedBookIndex];
+        bool queued = std::any_of(basket.begin(), basket.end(),
+                                  [&](const BookListItem& b) { return b.isbn == book.isbn; });
+        if (!queued) basket.push_back(book);
+    }
 
-        // 3. Додаємо позичку
-        addLoan();
+    if (writesInFlight > 0 || loading) {
+        ImGui::SameLine();
+        ImGui::TextDisabled(writesInFlight > 0 ? "Збереження..." : "Завантаження...");
+    }
+
+    if (!basket.empty()) {
+        ImGui::Text("Кошик (%d):", static_cast<int>(basket.size()));
+        for (size_t i = 0; i < basket.size(); ++i) {
+            ImGui::PushID(static_cast<int>(i));
+            if (ImGui::SmallButton("x")) {
+                basket.erase(basket.begin() + i);
+                ImGui::PopID();
+                break;
+            }
+            ImGui::SameLine();
+            ImGui::Text("%s", basket[i].title.c_str());
+            ImGui::PopID();
+        }
+        ImGui::BeginDisabled(writesInFlight > 0);
+        bool basketClicked = ImGui::Button("Позичити все");
+        ImGui::EndDisabled();
+        if (basketClicked) {
+            if (selectedMemberIndex < 0) ImGui::OpenPopup("Помилка");
+            else checkoutBasket();
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Очистити кошик")) basket.clear();
     }
 
 
@@ -138,6 +223,20 @@ void LoanManager::renderBorrowSection() {
         ImGui::EndPopup();
     }
 
+    // --- POPUP: Відмова ---
+    if (ImGui::BeginPopupModal("ВідмоваПозички", nullptr, ImGuiWindowFlags_AlwaysAutoResize)) {
+        ImGui::Text("%s", checkoutError.c_str());
+        if (ImGui::Button("OK")) ImGui::CloseCurrentPopup();
+        ImGui::EndPopup();
+    }
+
+    // --- POPUP: Результат кошика ---
+    if (ImGui::BeginPopupModal("РезультатКошика", nullptr, ImGuiWindowFlags_AlwaysAutoResize)) {
+        for (const auto& line : basketReport) ImGui::Text("%s", line.c_str());
+        if (ImGui::Button("OK")) ImGui::CloseCurrentPopup();
+        ImGui::EndPopup();
+    }
+
     // --- POPUP: Успіх ---
     if (ImGui::BeginPopupModal("Позичка успішна", nullptr, ImGuiWindowFlags_AlwaysAutoResize)) {
         ImGui::Text("Книгу успішно позичено!");
@@ -162,17 +261,9 @@ void LoanManager::renderBorrowSection() {
             ImGui::TableSetupColumn("Доступно");
             ImGui::TableHeadersRow();
 
-            for (int i = 0; i < (int)books.size(); i++) {
-                const auto& book = books[i];
-
-                // Фільтр по пошуку
-                if (strlen(searchBuffer) > 0) {
-                    if (book.getTitle().find(searchBuffer) == std::string::npos &&
-                        book.getAuthor().find(searchBuffer) == std::string::npos &&
-                        book.getISBN().find(searchBuffer) == std::string::npos) {
-                        continue;
-                    }
-                }
+            const std::vector<BookListItem>& shown = borrowBooks();
+            for (int i = 0; i < (int)shown.size(); i++) {
+                const auto& book = shown[i];
 
                 // Не показуємо недоступні книги
                 if (!book.isAvailable()) continue;
@@ -180,20 +271,20 @@ void LoanManager::renderBorrowSection() {
                 ImGui::TableNextRow();
                 ImGui::TableSetColumnIndex(0);
 
-                if (ImGui::Selectable(book.getISBN().c_str(),
+                if (ImGui::Selectable(book.isbn.c_str(),
                                       selectedBookIndex == i,
                                       ImGuiSelectableFlags_SpanAllColumns)) {
                     selectedBookIndex = i;
                 }
 
                 ImGui::TableSetColumnIndex(1);
-                ImGui::Text("%s", book.getTitle().c_str());
+                ImGui::Text("%s", book.title.c_str());
 
                 ImGui::TableSetColumnIndex(2);
-                ImGui::Text("%s", book.getAuthor().c_str());
+                ImGui::Text("%s", book.author.c_str());
 
                 ImGui::TableSetColumnIndex(3);
-                ImGui::Text("%d", book.getAvailableCopies());
+                ImGui::Text("%d", book.availableCopies);
             }
 
             ImGui::EndTable();
@@ -210,12 +301,13 @@ void LoanManager::renderBorrowSection() {
     // ================== ТАБЛИЦЯ ЧИТАЧІВ ==================
     if (ImGui::BeginChild("MembersTableChild", ImVec2(0, 400), true)) {
 
-        if (ImGui::BeginTable("MembersTable", 3,
+        if (ImGui::BeginTable("MembersTable", 4,
             ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
 
             ImGui::TableSetupColumn("ID");
             ImGui::TableSetupColumn("ПІБ");
             ImGui::TableSetupColumn("Телефон");
+            ImGui::TableSetupColumn("Книг");
             ImGui::TableHeadersRow();
 
             for (int i = 0; i < (int)members.size(); i++) {
@@ -224,17 +316,25 @@ void LoanManager::renderBorrowSection() {
                 ImGui::TableNextRow();
                 ImGui::TableSetColumnIndex(0);
 
-                if (ImGui::Selectable(std::to_string(member.getId()).c_str(),
+                if (ImGui::Selectable(std::to_string(member.id).c_str(),
                                       selectedMemberIndex == i,
                                       ImGuiSelectableFlags_SpanAllColumns)) {
                     selectedMemberIndex = i;
                 }
 
                 ImGui::TableSetColumnIndex(1);
-                ImGui::Text("%s", member.getName().c_str());
+                ImGui::Text("%s", member.name.c_str());
 
                 ImGui::TableSetColumnIndex(2);
-                ImGui::Text("%s", member.getPhone().c_str());
+                ImGui::Text("%s", member.phone.c_str());
+
+                // Active loans against the member's limit, overdue ones in brackets
+                ImGui::TableSetColumnIndex(3);
+                auto counts = memberLoanCounts.find(member.id);
+                int active = counts == memberLoanCounts.end() ? 0 : counts->second.active;
+                int overdue = counts == memberLoanCounts.end() ? 0 : counts->second.overdue;
+                if (overdue > 0) ImGui::Text("%d/%d (%d простр.)", active, member.maxBooksAllowed, overdue);
+                else ImGui::Text("%d/%d", active, member.maxBooksAllowed);
             }
 
             ImGui::EndTable();
@@ -245,111 +345,155 @@ void LoanManager::renderBorrowSection() {
     ImGui::Columns(1);
 }
 
+static const char* bookTitle(const LoanView& view) {
+    return view.bookTitle.empty() ? "Невідома книга" : view.bookTitle.c_str();
+}
+
+static const char* memberName(const LoanView& view) {
+    return view.memberName.empty() ? "Невідомий читач" : view.memberName.c_str();
+}
+
+static std::string toString(const std::chrono::system_clock::time_point& tp) {
+    if (tp.time_since_epoch().count() == 0) return "-";
+    std::time_t t = std::chrono::system_clock::to_time_t(tp);
+    std::tm tm;
+#ifdef _WIN32
+    localtime_s(&tm, &t);
+#else
+    localtime_r(&t, &tm);
+#endif
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%d", &tm);
+    return std::string(buf);
+}
+
 void LoanManager::renderReturnSection() {
     ImGui::Text("Повернення книги");
     ImGui::Separator();
 
-    std::vector<Loan> activeLoans = dbManager.getActiveLoans();
+    if (returnPopup) {
+        ImGui::OpenPopup(returnPopup);
+        returnPopup = nullptr;
+    }
+    renderReturnTable();
+
+    if (ImGui::BeginPopupModal("Повернено", nullptr, ImGuiWindowFlags_AlwaysAutoResize)) {
+        if (lastReturnCount == 1) ImGui::Text("Книга успішно повернена!");
+        else ImGui::Text("Повернено книг: %d", lastReturnCount);
+        if (ImGui::Button("OK")) ImGui::CloseCurrentPopup();
+        ImGui::EndPopup();
+    }
+}
+
+void LoanManager::renderReturnTable() {
     if (activeLoans.empty()) {
         ImGui::Text("Немає активних позичень");
         return;
     }
 
-    auto toString = [](const std::chrono::system_clock::time_point& tp) -> std::string {
-        if (tp.time_since_epoch().count() == 0) return "-";
-        std::time_t t = std::chrono::system_clock::to_time_t(tp);
-        std::tm tm;
-    #ifdef _WIN32
-        localtime_s(&tm, &t);
-    #else
-        localtime_r(&t, &tm);
-    #endif
-        char buf[32];
-        std::strftime(buf, sizeof(buf), "%Y-%m-%d", &tm);
-        return std::string(buf);
-    };
-
-    if (ImGui::BeginTable("ActiveLoans", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
+    // Book-drop mode: tick the returned loans and check them all in with one transaction
+    if (ImGui::Button("Вибрати всі")) {
+        for (const auto& view : activeLoans) selectedReturns.insert(view.loan.getId());
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Зняти вибір")) selectedReturns.clear();
+    ImGui::SameLine();
+    ImGui::BeginDisabled(selectedReturns.empty() || writesInFlight > 0);
+    std::string batchLabel = "Повернути вибрані (" + std::to_string(selectedReturns.size()) + ")";
+    if (ImGui::Button(batchLabel.c_str())) {
+        returnLoans(std::vector<int>(selectedReturns.begin(), selectedReturns.end()));
+    }
+    ImGui::EndDisabled();
+
+    if (ImGui::BeginTable("ActiveLoans", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
+        ImGui::TableSetupColumn("", ImGuiTableColumnFlags_WidthFixed);
         ImGui::TableSetupColumn("Книга");
         ImGui::TableSetupColumn("Читач");
         ImGui::TableSetupColumn("Дата позичення");
         ImGui::TableSetupColumn("Термін повернення");
         ImGui::TableSetupColumn("Статус");
         ImGui::TableSetupColumn("Дія");
+        ImGui::TableSetupScrollFreeze(0, 1);
         ImGui::TableHeadersRow();
 
-        for (size_t i = 0; i < activeLoans.size(); ++i) {
-            Loan& loan = activeLoans[i];
-            ImGui::TableNextRow();
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(activeLoans.size()));
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                const Loan& loan = activeLoans[i].loan;
+                ImGui::PushID(loan.getId());
+                ImGui::TableNextRow();
 
-            ImGui::TableSetColumnIndex(0); ImGui::Text("%s", getBookTitle(loan.getBookISBN()).c_str());
-            ImGui::TableSetColumnIndex(1); ImGui::Text("%s", getMemberName(loan.getMemberId()).c_str());
-            ImGui::TableSetColumnIndex(2); ImGui::Text("%s", toString(loan.getLoanDate()).c_str());
-            ImGui::TableSetColumnIndex(3); ImGui::Text("%s", toString(loan.getDueDate()).c_str());
+                ImGui::TableSetColumnIndex(0);
+                bool selected = selectedReturns.count(loan.getId()) > 0;
+                if (ImGui::Checkbox("##selected", &selected)) {
+                    if (selected) selectedReturns.insert(loan.getId());
+                    else selectedReturns.erase(loan.getId());
+                }
 
-            // status/fine
-            std::string statusStr = loan.isOverdue() ? "Прострочено" : "Вчасно";
-            double fine = loan.calculateFine();
-            if (fine > 0.0) {
-                statusStr += " (штраф: " + std::to_string(static_cast<int>(fine)) + ")";
-            }
-            ImGui::TableSetColumnIndex(4); ImGui::Text("%s", statusStr.c_str());
-
-            // Action: render a clickable table cell (selectable text) instead of a button, looks more natural in a table
-            ImGui::TableSetColumnIndex(5);
-
-            // Style the action like a link
-            ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.12f, 0.48f, 0.95f, 1.0f));
-            // Use Selectable without SpanAllColumns so only this cell is clickable
-            std::string actionLabel = "Повернути##" + std::to_string(i);
-            if (ImGui::Selectable(actionLabel.c_str(), false, 0)) {
-                // perform return flow (update loan in DB and refresh)
-                if (returnLoan(loan)) {
-                    loadData();
-                    ImGui::OpenPopup("Повернено");
+                ImGui::TableSetColumnIndex(1); ImGui::Text("%s", bookTitle(activeLoans[i]));
+                ImGui::TableSetColumnIndex(2); ImGui::Text("%s", memberName(activeLoans[i]));
+                ImGui::TableSetColumnIndex(3); ImGui::Text("%s", toString(loan.getLoanDate()).c_str());
+                ImGui::TableSetColumnIndex(4); ImGui::Text("%s", toString(loan.getDueDate()).c_str());
+
+                // status/fine
+                std::string statusStr = loan.isOverdue() ? "Прострочено" : "Вчасно";
+                double fine = loan.calculateFine();
+                if (fine > 0.0) {
+                    statusStr += " (штраф: " + std::to_string(static_cast<int>(fine)) + ")";
+                }
+                ImGui::TableSetColumnIndex(5); ImGui::Text("%s", statusStr.c_str());
+
+                // Action: render a clickable table cell (selectable text) instead of a button, looks more natural in a table
+                ImGui::TableSetColumnIndex(6);
+
+                // Style the action like a link
+                ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.12f, 0.48f, 0.95f, 1.0f));
+                // Use Selectable without SpanAllColumns so only this cell is clickable
+                if (ImGui::Selectable("Повернути", false, 0)) {
+                    returnLoans({ loan.getId() });
                 }
+                ImGui::PopStyleColor();
+                ImGui::PopID();
             }
-            ImGui::PopStyleColor();
         }
         ImGui::EndTable();
     }
-
-    if (ImGui::BeginPopupModal("Повернено", nullptr, ImGuiWindowFlags_AlwaysAutoResize)) {
-        ImGui::Text("Книга успішно повернена!");
-        if (ImGui::Button("OK")) ImGui::CloseCurrentPopup();
-        ImGui::EndPopup();
-    }
 }
 
-bool LoanManager::returnLoan(Loan& loan) {
-    // Let Loan::returnBook compute returnDate and fineAmount (it updates its internals).
-    if (!loan.returnBook()) return false;
-
-    // Let DatabaseManager handle the transactional DB update (it will also increment available_copies).
-    if (!dbManager.updateLoan(loan)) return false;
+// Fines and restored copies are computed by the database at the same return time for the whole batch.
+// UI data is refreshed through refreshData() once the loans data version moves.
+void LoanManager::returnLoans(const std::vector<int>& loanIds) {
+    for (int id : loanIds) selectedReturns.erase(id);
+    ++writesInFlight;
+    worker.submit([loanIds, now = std::chrono::system_clock::now()](DatabaseManager& db) {
+            int returned = 0;
+            return db.returnBatch(loanIds, now, &returned) ? returned : -1;
+        },
+        [this](int returned) {
+            --writesInFlight;
+            if (returned < 0) return;
+            lastReturnCount = returned;
+            returnPopup = "Повернено";
+        });
+}
 
-    // Refresh UI data from DB to reflect the change.
-    loadData();
-    return true;
+// --- ПІДСУМКИ ---
+void LoanManager::renderSummary() {
+    ImGui::Text("Видано: %d (прострочено: %d)   Примірників доступно: %d з %d   Назв без вільних примірників: %d",
+                summary.activeLoans, summary.overdueLoans, summary.availableCopies, summary.totalCopies,
+                summary.unavailableTitles);
+    for (const auto& totals : typeTotals) {
+        std::string type = Member::typeToString(totals.type);
+        ImGui::Text("%s: читачів %d, видано %d, прострочено %d",
+                    type.c_str(), totals.members, totals.activeLoans, totals.overdueLoans);
+    }
+    ImGui::Separator();
 }
 
 // --- ВІДОБРАЖЕННЯ ВСІХ ПОЗИЧОК ---
 void LoanManager::renderLoanList() {
     // Make the Loans list look like other tables (headers, row-bg, scroll)
-    auto toString = [](const std::chrono::system_clock::time_point& tp) -> std::string {
-        if (tp.time_since_epoch().count() == 0) return "-";
-        std::time_t t = std::chrono::system_clock::to_time_t(tp);
-        std::tm tm;
-    #ifdef _WIN32
-        localtime_s(&tm, &t);
-    #else
-        localtime_r(&t, &tm);
-    #endif
-        char buf[32];
-        std::strftime(buf, sizeof(buf), "%Y-%m-%d", &tm);
-        return std::string(buf);
-    };
-
     // Use a 7-column table: ID, Book, Member, Loan Date, Due Date, Return Date, Status
     if (ImGui::BeginTable("LoansTable", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
         ImGui::TableSetupColumn("ID");
@@ -359,57 +503,148 @@ void LoanManager::renderLoanList() {
         ImGui::TableSetupColumn("Термін повернення");
         ImGui::TableSetupColumn("Дата повернення");
         ImGui::TableSetupColumn("Статус");
+        ImGui::TableSetupScrollFreeze(0, 1);
         ImGui::TableHeadersRow();
 
-        for (size_t i = 0; i < loans.size(); ++i) {
-            const auto& loan = loans[i];
-            ImGui::TableNextRow();
+        ImGuiListClipper clipper;
+        clipper.Begin(pagedLoans.size());
+        int firstVisible = pagedLoans.size(), lastVisible = 0;
+        while (clipper.Step()) {
+            firstVisible = std::min(firstVisible, clipper.DisplayStart);
+            lastVisible = std::max(lastVisible, clipper.DisplayEnd);
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                const LoanView* view = pagedLoans.row(i);
+                if (view) {
+                    renderLoanRow(*view);
+                } else {
+                    // Page still on its way from the worker
+                    ImGui::TableNextRow();
+                    ImGui::TableSetColumnIndex(0);
+                    ImGui::TextDisabled("...");
+                }
+            }
+        }
+        pagedLoans.trim(firstVisible, lastVisible);
 
-            ImGui::TableSetColumnIndex(0);
-            ImGui::Text("%d", loan.getId());
+        ImGui::EndTable();
+    }
+}
 
-            ImGui::TableSetColumnIndex(1);
-            ImGui::Text("%s", getBookTitle(loan.getBookISBN()).c_str());
+void LoanManager::renderLoanRow(const LoanView& view) {
+    const Loan& loan = view.loan;
+    ImGui::TableNextRow();
 
-            ImGui::TableSetColumnIndex(2);
-            ImGui::Text("%s", getMemberName(loan.getMemberId()).c_str());
+    ImGui::TableSetColumnIndex(0);
+    ImGui::Text("%d", loan.getId());
 
-            ImGui::TableSetColumnIndex(3);
-            ImGui::Text("%s", toString(loan.getLoanDate()).c_str());
+    ImGui::TableSetColumnIndex(1);
+    ImGui::Text("%s", bookTitle(view));
 
-            ImGui::TableSetColumnIndex(4);
-            ImGui::Text("%s", toString(loan.getDueDate()).c_str());
+    ImGui::TableSetColumnIndex(2);
+    ImGui::Text("%s", memberName(view));
 
-            ImGui::TableSetColumnIndex(5);
-            ImGui::Text("%s", toString(loan.getReturnDate()).c_str());
+    ImGui::TableSetColumnIndex(3);
+    ImGui::Text("%s", toString(loan.getLoanDate()).c_str());
 
-            ImGui::TableSetColumnIndex(6);
-            std::string status = loan.getIsReturned() ? "Повернено" : (loan.isOverdue() ? "Просрочено" : "В процесі");
-            double fine = loan.calculateFine();
-            if (fine > 0.0 && !loan.getIsReturned()) {
-                status += " (штраф: " + std::to_string(static_cast<int>(fine)) + ")";
-            }
-            ImGui::Text("%s", status.c_str());
-        }
+    ImGui::TableSetColumnIndex(4);
+    ImGui::Text("%s", toString(loan.getDueDate()).c_str());
 
-        ImGui::EndTable();
+    ImGui::TableSetColumnIndex(5);
+    ImGui::Text("%s", toString(loan.getReturnDate()).c_str());
+
+    ImGui::TableSetColumnIndex(6);
+    std::string status = loan.getIsReturned() ? "Повернено" : (loan.isOverdue() ? "Просрочено" : "В процесі");
+    double fine = loan.calculateFine();
+    if (fine > 0.0 && !loan.getIsReturned()) {
+        status += " (штраф: " + std::to_string(static_cast<int>(fine)) + ")";
     }
+    ImGui::Text("%s", status.c_str());
 }
 
+// Everything the loan tabs show, loaded in one job on the worker
+struct LoanTabData {
+    std::vector<BookListItem> books;
+    std::vector<MemberListItem> members;
+    std::vector<LoanView> activeLoans;
+    std::vector<MemberLoanCounts> memberLoanCounts;
+    std::vector<MemberTypeTotals> typeTotals;
+    LibrarySummary summary;
+    int loanCount = 0;
+};
+
 void LoanManager::loadData() {
-    books = dbManager.getAllBooks();
-    members = dbManager.getAllMembers();
-    loans = dbManager.getAllLoans();
+    booksVersion = worker.dataVersion(DataTable::Books);
+    membersVersion = worker.dataVersion(DataTable::Members);
+    loansVersion = worker.dataVersion(DataTable::Loans);
+    loading = true;
+
+    worker.submit([](DatabaseManager& db) {
+            LoanTabData data;
+            // Only what the pick lists show; unavailable books are never listed there
+            data.books = db.getBookList(true);
+            data.members = db.getMemberList();
+            data.activeLoans = db.getActiveLoanViews();
+            data.memberLoanCounts = db.getMemberLoanCounts();
+            data.typeTotals = db.getMemberTypeTotals();
+            data.summary = db.getLibrarySummary();
+            data.loanCount = db.countLoans();
+            return data;
+        },
+        [this](LoanTabData data) {
+            books = std::move(data.books);
+            members = std::move(data.members);
+            activeLoans = std::move(data.activeLoans);
+            memberLoanCounts.clear();
+            memberLoanCounts.reserve(data.memberLoanCounts.size());
+            for (const auto& counts : data.memberLoanCounts) memberLoanCounts[counts.memberId] = counts;
+            typeTotals = std::move(data.typeTotals);
+            summary = data.summary;
+            loading = false;
+            searchBorrowBooks();
+
+            // Forget ticks on loans that were checked in elsewhere
+            std::set<int> stillActive;
+            for (const auto& view : activeLoans) {
+                if (selectedReturns.count(view.loan.getId())) stillActive.insert(view.loan.getId());
+            }
+            selectedReturns = std::move(stillActive);
+
+            // Loan history can be huge, so the list tab only keeps the pages it is showing
+            pagedLoans.reset(data.loanCount);
+        });
+}
+
+// Reload only when one of the tables shown in the loan tabs changed since the last load.
+void LoanManager::refreshData() {
+    if (loading) return;
+    if (worker.dataVersion(DataTable::Books) == booksVersion &&
+        worker.dataVersion(DataTable::Members) == membersVersion &&
+        worker.dataVersion(DataTable::Loans) == loansVersion) {
+        return;
+    }
+    loadData();
 }
 
-std::string LoanManager::getBookTitle(const std::string& isbn) const {
-    for (const auto& book : books)
-        if (book.getISBN() == isbn) return book.getTitle();
-    return "Невідома книга";
+// The borrow tab filters through the search index instead of scanning every book each frame.
+void LoanManager::searchBorrowBooks() {
+    std::string query = searchBuffer;
+    if (query.empty()) {
+        bookMatches.clear();
+        matchedQuery.clear();
+        selectedBookIndex = -1;
+        return;
+    }
+    // Same books as the unfiltered list: only those with a copy to lend
+    worker.submit([query](DatabaseManager& db) { return db.searchBookList(query, true); },
+        [this, query](std::vector<BookListItem> found) {
+            // A newer search may have been typed meanwhile; only the latest one is shown
+            if (query != searchBuffer) return;
+            bookMatches = std::move(found);
+            matchedQuery = query;
+            selectedBookIndex = -1;
+        });
 }
 
-std::string LoanManager::getMemberName(int memberId) const {
-    for (const auto& member : members)
-        if (member.getId() == memberId) return member.getName();
-    return "Невідомий читач";
+const std::vector<BookListItem>& LoanManager::borrowBooks() const {
+    return matchedQuery.empty() ? books : bookMatches;
 }
@@ -1,37 +1,61 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <set>
+#include <unordered_map>
 #include "../core/Book.h"
 #include "../core/Member.h"
 #include "../core/Loan.h"
-#include "../database/DatabaseManager.h"
+#include "../database/DatabaseWorker.h"
+#include "PagedTable.h"
 
 class LoanManager {
 private:
-    DatabaseManager& dbManager;
-    std::vector<Loan> loans;
-    std::vector<Book> books;
-    std::vector<Member> members;
+    DatabaseWorker& worker;
+    std::vector<BookListItem> books;         // available books only
+    std::vector<BookListItem> bookMatches;   // borrow tab search results
+    std::string matchedQuery;        // query bookMatches belongs to
+    std::vector<MemberListItem> members;
+    std::vector<LoanView> activeLoans;
+    std::unordered_map<int, MemberLoanCounts> memberLoanCounts;   // by member id; members with active loans only
+    std::vector<MemberTypeTotals> typeTotals;
+    LibrarySummary summary;
+    PagedTable<LoanView, LoanPageKey> pagedLoans;
+    DataVersion booksVersion;
+    DataVersion membersVersion;
+    DataVersion loansVersion;
+    bool loading = false;
+    int writesInFlight = 0;
+    const char* borrowPopup = nullptr;   // popups requested by completions, opened inside their tab
+    const char* returnPopup = nullptr;
 
     char searchBuffer[256] = "";
     int selectedBookIndex = -1;
     int selectedMemberIndex = -1;
     int loanDays = 14;
-    int selectedLoanIndex = -1;
+    std::set<int> selectedReturns;    // loan ids ticked in the return tab
+    int lastReturnCount = 0;
+    std::string checkoutError;
+    std::vector<BookListItem> basket;          // books queued for one batch checkout
+    std::vector<std::string> basketReport;
 
+    void renderSummary();
     void renderLoanList();
+    void renderLoanRow(const LoanView& view);
     void renderBorrowSection();
     void renderReturnSection();
-    std::string getBookTitle(const std::string& isbn) const;
-    std::string getMemberName(int memberId) const;
+    void renderReturnTable();
+    void searchBorrowBooks();
+    const std::vector<BookListItem>& borrowBooks() const;
     void addLoan();
-    bool maxBooksAllowedExceeded(const Member& member) const;
-    bool returnLoan(Loan& loan);
+    void checkoutBasket();
+    void returnLoans(const std::vector<int>& loanIds);
 
 public:
-    LoanManager(DatabaseManager& db);
+    LoanManager(DatabaseWorker& worker);
 
     void render();
     void loadData();
+    void refreshData();
 };
 
@@ -1,12 +1,30 @@
 #include "MainWindow.h"
 #include "imgui.h"
+#include <ctime>
 
-MainWindow::MainWindow() 
-    : bookManager(std::make_unique<BookManager>(dbManager))
-    , memberManager(std::make_unique<MemberManager>(dbManager))
-    , loanManager(std::make_unique<LoanManager>(dbManager)) {}
+MainWindow::MainWindow(const StorageOptions& storage)
+    : dbManager("data/library.db", storage)
+    , worker(dbManager)
+    , backups(dbManager)
+    , reports(dbManager, &worker)
+    , bookManager(std::make_unique<BookManager>(worker))
+    , memberManager(std::make_unique<MemberManager>(worker))
+    , loanManager(std::make_unique<LoanManager>(worker))
+    , reportManager(std::make_unique<ReportManager>(reports))
+    , diagnosticsManager(std::make_unique<DiagnosticsManager>(worker, dbManager.queryStats(), dbManager.slowQueryLog())) {
+    // Index builds left out of startup; queries fall back to scans until they land
+    worker.submit([](DatabaseManager& db) { db.runPendingMigrations(); });
+}
+
+MainWindow::~MainWindow() {
+    // Queued jobs reference the managers, so the worker has to finish before they are destroyed
+    worker.stop();
+}
 
 void MainWindow::render() {
+    // Hand finished database work back to the tabs before they draw
+    worker.poll();
+    reports.poll();
     renderMainContent();
 }
 
@@ -34,6 +52,21 @@ void MainWindow::renderMainContent() {
             ImGui::EndTabItem();
         }
         
+        if (ImGui::BeginTabItem("Звіти")) {
+            reportManager->render();
+            ImGui::EndTabItem();
+        }
+        
+        if (ImGui::BeginTabItem("Резервні копії")) {
+            renderBackupTab();
+            ImGui::EndTabItem();
+        }
+        
+        if (ImGui::BeginTabItem("Діагностика")) {
+            diagnosticsManager->render();
+            ImGui::EndTabItem();
+        }
+        
         if (ImGui::BeginTabItem("Про систему")) {
             ImGui::Text("Library Manager v0.8");
             ImGui::Text("Розроблено для курсової роботи");
@@ -46,3 +79,45 @@ void MainWindow::renderMainContent() {
     
     ImGui::End();
 }
+
+static std::string formatTime(const std::chrono::system_clock::time_point& tp) {
+    if (tp.time_since_epoch().count() == 0) return "-";
+    std::time_t t = std::chrono::system_clock::to_time_t(tp);
+    std::tm tm;
+#ifdef _WIN32
+    localtime_s(&tm, &t);
+#else
+    localtime_r(&t, &tm);
+#endif
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M", &tm);
+    return std::string(buf);
+}
+
+void MainWindow::renderBackupTab() {
+    BackupStatus status = backups.getStatus();
+    const BackupProgress& progress = status.progress;
+    double mib = progress.bytesCopied / (1024.0 * 1024.0);
+
+    if (status.running) {
+        float done = progress.pagesTotal > 0
+            ? 1.0f - static_cast<float>(progress.pagesRemaining) / progress.pagesTotal : 0.0f;
+        ImGui::Text("Створюється резервна копія...");
+        ImGui::ProgressBar(done, ImVec2(300, 0));
+        ImGui::Text("Скопійовано %.1f МіБ, %.1f МіБ/с", mib, progress.mibPerSecond());
+    } else if (ImGui::Button("Створити копію зараз")) {
+        backups.requestBackup();
+    }
+
+    ImGui::Separator();
+    if (!status.lastFile.empty()) {
+        ImGui::Text("Остання копія: %s", status.lastFile.c_str());
+        ImGui::Text("Створено: %s (%.1f МіБ за %.1f с)", formatTime(status.lastFinished).c_str(), mib, progress.seconds);
+    } else {
+        ImGui::Text("Резервних копій ще не створено");
+    }
+    if (!status.lastError.empty()) {
+        ImGui::TextColored(ImVec4(0.85f, 0.2f, 0.2f, 1.0f), "%s", status.lastError.c_str());
+    }
+    ImGui::Text("Наступна за розкладом: %s", formatTime(status.nextDue).c_str());
+}
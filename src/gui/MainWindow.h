@@ -2,20 +2,33 @@
 #include "BookManager.h"
 #include "MemberManager.h"
 #include "LoanManager.h"
+#include "ReportManager.h"
+#include "DiagnosticsManager.h"
 #include "../database/DatabaseManager.h"
+#include "../database/DatabaseWorker.h"
+#include "../database/BackupScheduler.h"
 #include <memory>
 
 class MainWindow {
 private:
     DatabaseManager dbManager;
+    DatabaseWorker worker;            // every database call from the tabs goes through here
+    BackupScheduler backups;
+    ReportingSnapshot reports;        // heavy reports read a private copy, never the desk's database
     std::unique_ptr<BookManager> bookManager;
     std::unique_ptr<MemberManager> memberManager;
     std::unique_ptr<LoanManager> loanManager;
+    std::unique_ptr<ReportManager> reportManager;
+    std::unique_ptr<DiagnosticsManager> diagnosticsManager;
 
     void renderMenuBar();
     void renderMainContent();
+    void renderBackupTab();
     
 public:
-    MainWindow();
+    // Storage for the desk's database; StorageOptions::wal() lets the worker and reports read
+    // alongside the desk's writes
+    explicit MainWindow(const StorageOptions& storage = StorageOptions());
+    ~MainWindow();
     void render();
 };
@@ -1,12 +1,18 @@
+#include <algorithm>
 #include "MemberManager.h"
 #include "imgui.h"
 
-MemberManager::MemberManager(DatabaseManager& db) : dbManager(db) {
-    loadMembers();
-}
+MemberManager::MemberManager(DatabaseWorker& worker)
+    : worker(worker),
+      pagedMembers(worker,
+                   [this](const std::optional<MemberPageKey>& after, int limit) {
+                       return [after, limit, sort = sortColumn](DatabaseManager& db) { return db.getMembersPage(after, limit, sort); };
+                   },
+                   [this](const Member& member) { return DatabaseManager::memberPageKey(member, sortColumn); }) {}
 
 void MemberManager::render() {
     renderSearchBar();
+    refreshMembers();
     
     ImGui::Separator();
     
@@ -19,9 +25,9 @@ void MemberManager::render() {
     }
     
     ImGui::SameLine();
-    if (ImGui::Button("Редагувати") && selectedMemberIndex >= 0) {
+    if (ImGui::Button("Редагувати") && selectedMember) {
         showEditMemberPopup = true;
-        const auto& member = members[selectedMemberIndex];
+        const auto& member = *selectedMember;
         
         strncpy(nameBuffer, member.getName().c_str(), sizeof(nameBuffer) - 1);
         strncpy(emailBuffer, member.getEmail().c_str(), sizeof(emailBuffer) - 1);
@@ -36,8 +42,8 @@ void MemberManager::render() {
     }
     
     ImGui::SameLine();
-    if (ImGui::Button("Видалити") && selectedMemberIndex >= 0) {
-        deleteMember(selectedMemberIndex);
+    if (ImGui::Button("Видалити") && selectedMember) {
+        deleteMember(selectedMember->getId());
     }
     
     ImGui::Spacing();
@@ -58,41 +64,73 @@ void MemberManager::renderSearchBar() {
     ImGui::SameLine();
     ImGui::SetNextItemWidth(400);  
     ImGui::InputText("##search", searchBuffer, sizeof(searchBuffer));
-    if (strlen(searchBuffer) > 0) {
-        searchMembers(searchBuffer);
+
+    if (loading || pagedMembers.loading()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("Завантаження...");
     }
 }
 
 void MemberManager::renderMemberList() {
-    if (ImGui::BeginTable("MembersTable", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
-        ImGui::TableSetupColumn("ID");
-        ImGui::TableSetupColumn("ПІБ");
-        ImGui::TableSetupColumn("Email");
-        ImGui::TableSetupColumn("Телефон");
-        ImGui::TableSetupColumn("Тип");
+    if (ImGui::BeginTable("MembersTable", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_Sortable)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("ID", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_NoSortDescending);
+        ImGui::TableSetupColumn("ПІБ", ImGuiTableColumnFlags_NoSortDescending);
+        ImGui::TableSetupColumn("Email", ImGuiTableColumnFlags_NoSort);
+        ImGui::TableSetupColumn("Телефон", ImGuiTableColumnFlags_NoSort);
+        ImGui::TableSetupColumn("Тип", ImGuiTableColumnFlags_NoSort);
         ImGui::TableHeadersRow();
 
-        for (int i = 0; i < static_cast<int>(members.size()); i++) {
-            const auto& member = members[i];
+        if (ImGuiTableSortSpecs* sortSpecs = ImGui::TableGetSortSpecs()) {
+            if (sortSpecs->SpecsDirty && sortSpecs->SpecsCount > 0) {
+                sortColumn = static_cast<MemberSort>(sortSpecs->Specs[0].ColumnIndex);
+                membersLoaded = false;
+                sortSpecs->SpecsDirty = false;
+            }
+        }
 
-            ImGui::TableNextRow();
+        bool searching = !shownQuery.empty();
+        int rowCount = searching ? static_cast<int>(members.size()) : pagedMembers.size();
 
-            // Рядок клікабельний через Selectable
-            ImGui::TableSetColumnIndex(0);
-            if (ImGui::Selectable(std::to_string(member.getId()).c_str(), selectedMemberIndex == i, ImGuiSelectableFlags_SpanAllColumns)) {
-                selectedMemberIndex = i;
+        ImGuiListClipper clipper;
+        clipper.Begin(rowCount);
+        int firstVisible = rowCount, lastVisible = 0;
+        while (clipper.Step()) {
+            firstVisible = std::min(firstVisible, clipper.DisplayStart);
+            lastVisible = std::max(lastVisible, clipper.DisplayEnd);
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                const Member* member = searching ? &members[i] : pagedMembers.row(i);
+                if (member) {
+                    renderMemberRow(*member);
+                } else {
+                    // Page still on its way from the worker
+                    ImGui::TableNextRow();
+                    ImGui::TableSetColumnIndex(0);
+                    ImGui::TextDisabled("...");
+                }
             }
-
-            ImGui::TableSetColumnIndex(1); ImGui::Text("%s", member.getName().c_str());
-            ImGui::TableSetColumnIndex(2); ImGui::Text("%s", member.getEmail().c_str());
-            ImGui::TableSetColumnIndex(3); ImGui::Text("%s", member.getPhone().c_str());
-            ImGui::TableSetColumnIndex(4); ImGui::Text("%s", member.getTypeString().c_str());
         }
+        if (!searching) pagedMembers.trim(firstVisible, lastVisible);
 
         ImGui::EndTable();
     }
 }
 
+void MemberManager::renderMemberRow(const Member& member) {
+    ImGui::TableNextRow();
+
+    // Рядок клікабельний через Selectable
+    ImGui::TableSetColumnIndex(0);
+    bool selected = selectedMember && selectedMember->getId() == member.getId();
+    if (ImGui::Selectable(std::to_string(member.getId()).c_str(), selected, ImGuiSelectableFlags_SpanAllColumns)) {
+        selectedMember = member;
+    }
+
+    ImGui::TableSetColumnIndex(1); ImGui::Text("%s", member.getName().c_str());
+    ImGui::TableSetColumnIndex(2); ImGui::Text("%s", member.getEmail().c_str());
+    ImGui::TableSetColumnIndex(3); ImGui::Text("%s", member.getPhone().c_str());
+    ImGui::TableSetColumnIndex(4); ImGui::Text("%s", member.getTypeString().c_str());
+}
 
 void MemberManager::renderAddMemberPopup() {
     static std::string addMemberError;
@@ -187,56 +225,75 @@ void MemberManager::addMember() {
     Member::Type type = static_cast<Member::Type>(memberType);
     Member newMember(0, nameBuffer, emailBuffer, phoneBuffer, type);
     
-    if (dbManager.addMember(newMember)) {
-        loadMembers(); // Перезавантажити з БД для отримання правильного ID
-    }
+    // The members data version moves on insert, so refreshMembers() picks up the new ID afterwards
+    worker.submitWrite([newMember](DatabaseManager& db) { return db.addMember(newMember); });
 }
 
 void MemberManager::editMember() {
-    if (selectedMemberIndex >= 0 && static_cast<size_t>(selectedMemberIndex) < members.size()) {
-        const Member& old = members[selectedMemberIndex];
+    if (selectedMember) {
+        const Member& old = *selectedMember;
         int id = old.getId();
         Member::Type type = static_cast<Member::Type>(memberType);
         // preserve maxBooksAllowed from existing record
         int maxAllowed = old.getMaxBooksAllowed();
         Member updated(id, std::string(nameBuffer), std::string(emailBuffer), std::string(phoneBuffer), type, maxAllowed);
 
-        if (dbManager.updateMember(updated)) {
-            loadMembers();
-        } else {
-            // reload to reflect DB state if update failed
-            loadMembers();
-        }
+        worker.submitWrite([updated](DatabaseManager& db) { return db.updateMember(updated); },
+            [this, updated](bool ok) {
+                if (ok) {
+                    selectedMember = updated;
+                } else {
+                    // reload to reflect DB state if update failed
+                    membersLoaded = false;
+                }
+            });
     }
 }
 
-void MemberManager::deleteMember(int index) {
-    if (index >= 0 && static_cast<size_t>(index) < members.size()) {
-        int id = members[index].getId();
-        members.erase(members.begin() + index);
-        dbManager.deleteMember(id);
-        selectedMemberIndex = -1;
-    }
+void MemberManager::deleteMember(int id) {
+    worker.submitWrite([id](DatabaseManager& db) { return db.deleteMember(id); });
+    selectedMember.reset();
 }
 
-void MemberManager::loadMembers() {
-    members = dbManager.getAllMembers();
-}
+// Reload only when the members table, the search query or the sort changed since the last load. The
+// load runs on the worker; the rows already on screen stay until it completes.
+void MemberManager::refreshMembers() {
+    if (loading) return;
+    DataVersion version = worker.dataVersion(DataTable::Members);
+    std::string query = searchBuffer;
+    if (membersLoaded && version == loadedVersion && query == loadedQuery) return;
+
+    loadedVersion = version;
+    loadedQuery = query;
+    membersLoaded = true;
+    loading = true;
 
-void MemberManager::searchMembers(const std::string& query) {
     if (query.empty()) {
-        loadMembers();
+        worker.submit([](DatabaseManager& db) { return db.countMembers(); },
+            [this](int count) {
+                members.clear();
+                pagedMembers.reset(count);
+                shownQuery.clear();
+                loading = false;
+            });
         return;
     }
-    
-    std::vector<Member> allMembers = dbManager.getAllMembers();
-    members.clear();
-    
-    for (const auto& member : allMembers) {
-        if (member.getName().find(query) != std::string::npos ||
-            member.getEmail().find(query) != std::string::npos ||
-            member.getPhone().find(query) != std::string::npos) {
-            members.push_back(member);
-        }
-    }
+
+    worker.submit([query](DatabaseManager& db) {
+            std::vector<Member> found;
+            db.forEachMember([&](const Member& member) {
+                if (member.getName().find(query) != std::string::npos ||
+                    member.getEmail().find(query) != std::string::npos ||
+                    member.getPhone().find(query) != std::string::npos) {
+                    found.push_back(member);
+                }
+                return true;
+            });
+            return found;
+        },
+        [this, query](std::vector<Member> found) {
+            members = std::move(found);
+            shownQuery = query;
+            loading = false;
+        });
 }
@@ -2,12 +2,21 @@
 #include <vector>
 #include <string>
 #include "../core/Member.h"
-#include "../database/DatabaseManager.h"
+#include "../database/DatabaseWorker.h"
+#include "PagedTable.h"
 
 class MemberManager {
 private:
-    DatabaseManager& dbManager;
-    std::vector<Member> members;
+    DatabaseWorker& worker;
+    std::vector<Member> members;                        // search results
+    PagedTable<Member, MemberPageKey> pagedMembers;     // all members, fetched a page at a time
+    MemberSort sortColumn = MemberSort::Id;
+    std::optional<Member> selectedMember;
+    DataVersion loadedVersion;
+    std::string loadedQuery;                            // query of the last load submitted
+    std::string shownQuery;                             // query the rows on screen belong to
+    bool membersLoaded = false;
+    bool loading = false;
     
     // Стан для UI
     char searchBuffer[200] = "";
@@ -18,21 +27,20 @@ private:
     
     bool showAddMemberPopup = false;
     bool showEditMemberPopup = false;
-    int selectedMemberIndex = -1;
 
     void renderMemberList();
+    void renderMemberRow(const Member& member);
     void renderAddMemberPopup();
     void renderEditMemberPopup();
     void renderSearchBar();
     
     void addMember();
     void editMember();
-    void deleteMember(int index);
-    void searchMembers(const std::string& query);
+    void deleteMember(int id);
+    void refreshMembers();
 
 public:
-    MemberManager(DatabaseManager& db);
+    MemberManager(DatabaseWorker& worker);
     
     void render();
-    void loadMembers();
 };
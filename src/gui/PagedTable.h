@@ -0,0 +1,88 @@
+#pragma once
+#include <map>
+#include <set>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <functional>
+#include "../database/DatabaseWorker.h"
+
+// Window of keyset-paginated rows for a scrolling table. Only pages near the visible range are
+// kept in memory; the key where every page starts is remembered so evicted pages can be fetched
+// again with a single seek. Pages are fetched on the database worker: a row that is not loaded yet
+// reads as nullptr for a frame or two. Reaching a page whose start is not yet known walks forward
+// from the nearest known page, one page per fetch.
+template <typename Row, typename Key>
+class PagedTable {
+public:
+    using Query = std::function<std::vector<Row>(DatabaseManager&)>;
+    // Called on the UI thread; returns the query the worker runs, so it must capture by value.
+    using MakeQuery = std::function<Query(const std::optional<Key>& after, int limit)>;
+    using KeyOf = std::function<Key(const Row&)>;
+
+private:
+    DatabaseWorker& worker;
+    MakeQuery makeQuery;
+    KeyOf keyOf;
+    int pageSize;
+    int residentPages;
+    int totalRows = 0;
+    std::uint64_t generation = 0;                 // bumped by reset(); older fetches are ignored
+    std::vector<std::optional<Key>> pageStarts;   // pageStarts[p] is the key after which page p starts
+    std::map<int, std::vector<Row>> pages;
+    std::set<int> requested;
+
+    void request(int page) {
+        if (requested.count(page) || pages.count(page)) return;
+        requested.insert(page);
+        worker.submit(makeQuery(pageStarts[page], pageSize),
+            [this, page, requestedIn = generation](std::vector<Row> rows) {
+                if (requestedIn != generation) return;
+                requested.erase(page);
+                if (static_cast<int>(pageStarts.size()) == page + 1 && static_cast<int>(rows.size()) == pageSize) {
+                    pageStarts.push_back(keyOf(rows.back()));
+                }
+                pages[page] = std::move(rows);
+            });
+    }
+
+public:
+    PagedTable(DatabaseWorker& worker, MakeQuery makeQuery, KeyOf keyOf, int pageSize = 200, int residentPages = 6)
+        : worker(worker), makeQuery(std::move(makeQuery)), keyOf(std::move(keyOf)), pageSize(pageSize), residentPages(residentPages) {}
+
+    // Drops every cached page; call when the data or the sort order changed.
+    void reset(int rowCount) {
+        totalRows = rowCount;
+        ++generation;
+        pageStarts.assign(1, std::nullopt);
+        pages.clear();
+        requested.clear();
+    }
+
+    int size() const { return totalRows; }
+    bool loading() const { return !requested.empty(); }
+
+    const Row* row(int index) {
+        if (index < 0 || index >= totalRows) return nullptr;
+        int page = index / pageSize;
+        auto it = pages.find(page);
+        if (it == pages.end()) {
+            int known = static_cast<int>(pageStarts.size()) - 1;
+            // A resident last page shorter than pageSize means the table ended early
+            if (page <= known || !pages.count(known)) request(page <= known ? page : known);
+            return nullptr;
+        }
+        int offset = index % pageSize;
+        return offset < static_cast<int>(it->second.size()) ? &it->second[offset] : nullptr;
+    }
+
+    // Evicts pages far from the visible range [first, last).
+    void trim(int first, int last) {
+        int firstPage = first / pageSize - residentPages / 2;
+        int lastPage = last / pageSize + residentPages / 2;
+        for (auto it = pages.begin(); it != pages.end();) {
+            if (it->first < firstPage || it->first > lastPage) it = pages.erase(it);
+            else ++it;
+        }
+    }
+};
@@ -0,0 +1,128 @@
+#include <ctime>
+#include "ReportManager.h"
+#include "imgui.h"
+
+// Everything the report tab shows, computed in one job on the snapshot
+struct ReportData {
+    std::vector<MemberFineReport> fines;
+    std::vector<CirculationMonth> circulation;
+};
+
+ReportManager::ReportManager(ReportingSnapshot& snapshot) : snapshot(snapshot) {}
+
+void ReportManager::render() {
+    // Reports are only computed while the tab is open, and again whenever the snapshot moved on
+    if (!loading && (snapshot.stale() || reportTakenAt != snapshot.getTakenAt())) {
+        loadReports();
+    }
+
+    renderSnapshotAge();
+    ImGui::Separator();
+
+    if (ImGui::BeginTabBar("ReportTabs")) {
+        if (ImGui::BeginTabItem("Штрафи читачів")) {
+            renderFineReport();
+            ImGui::EndTabItem();
+        }
+        if (ImGui::BeginTabItem("Обіг за місяцями")) {
+            renderCirculationReport();
+            ImGui::EndTabItem();
+        }
+        ImGui::EndTabBar();
+    }
+}
+
+void ReportManager::loadReports() {
+    loading = true;
+    snapshot.submit([](DatabaseManager& db) {
+            ReportData data;
+            data.fines = db.getFineReport();
+            data.circulation = db.getCirculationReport();
+            return data;
+        },
+        [this](ReportData data) {
+            fines = std::move(data.fines);
+            circulation = std::move(data.circulation);
+            reportTakenAt = snapshot.getTakenAt();
+            loading = false;
+        });
+}
+
+void ReportManager::renderSnapshotAge() {
+    if (reportTakenAt.time_since_epoch().count() == 0) {
+        if (snapshot.refreshFailed() && !snapshot.isRefreshing()) {
+            ImGui::Text("Не вдалося зробити знімок бази для звітів, повторна спроба згодом");
+        } else {
+            ImGui::Text("Готується знімок бази для звітів...");
+        }
+        return;
+    }
+
+    std::time_t t = std::chrono::system_clock::to_time_t(reportTakenAt);
+    std::tm tm;
+#ifdef _WIN32
+    localtime_s(&tm, &t);
+#else
+    localtime_r(&t, &tm);
+#endif
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M", &tm);
+    auto minutes = std::chrono::duration_cast<std::chrono::minutes>(std::chrono::system_clock::now() - reportTakenAt).count();
+    ImGui::Text("Дані станом на %s (%lld хв тому)", buf, static_cast<long long>(minutes));
+
+    ImGui::SameLine();
+    ImGui::BeginDisabled(snapshot.isRefreshing() || loading);
+    if (ImGui::Button("Оновити")) {
+        snapshot.refresh();
+        loadReports();
+    }
+    ImGui::EndDisabled();
+    if (snapshot.isRefreshing() || loading) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("Завантаження...");
+    }
+}
+
+void ReportManager::renderFineReport() {
+    if (ImGui::BeginTable("FineReport", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
+        ImGui::TableSetupColumn("ID");
+        ImGui::TableSetupColumn("Читач");
+        ImGui::TableSetupColumn("Позичень");
+        ImGui::TableSetupColumn("Повернено із запізненням");
+        ImGui::TableSetupColumn("Штрафи");
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableHeadersRow();
+
+        for (const auto& row : fines) {
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0); ImGui::Text("%d", row.memberId);
+            ImGui::TableSetColumnIndex(1); ImGui::Text("%s", row.name.c_str());
+            ImGui::TableSetColumnIndex(2); ImGui::Text("%d", row.loans);
+            ImGui::TableSetColumnIndex(3); ImGui::Text("%d", row.lateReturns);
+            ImGui::TableSetColumnIndex(4); ImGui::Text("%.2f", row.fines);
+        }
+        ImGui::EndTable();
+    }
+}
+
+void ReportManager::renderCirculationReport() {
+    if (ImGui::BeginTable("CirculationReport", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
+        ImGui::TableSetupColumn("Місяць");
+        ImGui::TableSetupColumn("Позичено");
+        ImGui::TableSetupColumn("Повернено");
+        ImGui::TableSetupColumn("Із запізненням");
+        ImGui::TableSetupColumn("Штрафи");
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableHeadersRow();
+
+        for (const auto& row : circulation) {
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0); ImGui::Text("%s", row.month.c_str());
+            ImGui::TableSetColumnIndex(1); ImGui::Text("%d", row.loans);
+            ImGui::TableSetColumnIndex(2); ImGui::Text("%d", row.returned);
+            ImGui::TableSetColumnIndex(3); ImGui::Text("%d", row.lateReturns);
+            ImGui::TableSetColumnIndex(4); ImGui::Text("%.2f", row.fines);
+        }
+        ImGui::EndTable();
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <vector>
+#include <chrono>
+#include "../database/ReportingSnapshot.h"
+
+class ReportManager {
+private:
+    ReportingSnapshot& snapshot;
+    std::vector<MemberFineReport> fines;
+    std::vector<CirculationMonth> circulation;
+    std::chrono::system_clock::time_point reportTakenAt{};   // snapshot the rows on screen came from
+    bool loading = false;
+
+    void loadReports();
+    void renderSnapshotAge();
+    void renderFineReport();
+    void renderCirculationReport();
+
+public:
+    ReportManager(ReportingSnapshot& snapshot);
+
+    void render();
+};
@@ -1,9 +1,277 @@
 #include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <functional>
+#include <filesystem>
 #include "gui/Application.h"
+#include "database/DatabaseManager.h"
+#include "database/BulkImporter.h"
+#include "database/DatabaseWorker.h"
 
-int main() {
+static void printUsage() {
+    std::cout << "Usage:\n"
+              << "  LibrarySystem [--wal]                           start the desk application; --wal opens the\n"
+              << "                                                  database in WAL mode with read connections\n"
+              << "  LibrarySystem --import <books|members|loans> <file.csv> [--db path] [--threads N] [--batch N] [--no-header]\n"
+              << "  LibrarySystem --check-plans [--db path] [--run]  verify the hot queries use indexes\n"
+              << "  LibrarySystem --reconcile [--db path]            recompute copy and member loan counters, and\n"
+              << "                                                  restore what an unfinished import dropped\n"
+              << "  LibrarySystem --bench-load [--db path] [--threads N] [--runs N]\n"
+              << "                                                  time loading every loan on 1..N threads\n"
+              << "  LibrarySystem --bench-writes [--count N] [--window ms]\n"
+              << "                                                  time desk writes committed singly and grouped\n";
+}
+
+static int runImport(int argc, char** argv) {
+    if (argc < 4) {
+        printUsage();
+        return 1;
+    }
+
+    std::string kindName = argv[2];
+    ImportKind kind;
+    if (kindName == "books") kind = ImportKind::Books;
+    else if (kindName == "members") kind = ImportKind::Members;
+    else if (kindName == "loans") kind = ImportKind::Loans;
+    else {
+        printUsage();
+        return 1;
+    }
+
+    std::string csvPath = argv[3];
+    std::string dbPath = "data/library.db";
+    ImportOptions options;
+    for (int i = 4; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--db") == 0 && i + 1 < argc) dbPath = argv[++i];
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) options.parserThreads = std::stoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--batch") == 0 && i + 1 < argc) options.batchRows = std::stoul(argv[++i]);
+        else if (std::strcmp(argv[i], "--no-header") == 0) options.hasHeader = false;
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    {
+        // Opening through DatabaseManager creates the schema on a fresh file; the importer then
+        // drops and rebuilds whatever indexes exist, so build them all first
+        DatabaseManager schema(dbPath);
+        schema.runPendingMigrations();
+    }
+
+    std::cout << "Importing " << kindName << " from " << csvPath << " into " << dbPath << std::endl;
+    BulkImporter importer(dbPath, options);
+    ImportStats stats;
+    bool ok = importer.run(kind, csvPath, stats);
+
+    std::cout << "Read " << stats.rowsRead << ", imported " << stats.rowsImported
+              << ", rejected " << stats.rowsRejected << " in " << stats.seconds << " s ("
+              << static_cast<long long>(stats.rowsPerSecond()) << " rows/s)" << std::endl;
+    for (const auto& error : stats.sampleErrors) {
+        std::cout << "  rejected " << error << std::endl;
+    }
+    return ok ? 0 : 1;
+}
+
+static int runCheckPlans(int argc, char** argv) {
+    std::string dbPath = "data/library.db";
+    bool run = false;
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--db") == 0 && i + 1 < argc) dbPath = argv[++i];
+        else if (std::strcmp(argv[i], "--run") == 0) run = true;
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    // Report on the full schema, including the indexes the desk builds in the background
+    DatabaseManager db(dbPath);
+    db.runPendingMigrations();
+    bool ok = db.checkQueryPlans();
+    if (run) {
+        // Estimated rows (sqlite_stat1) against the rows each query returns with sample parameters
+        for (const auto& report : db.explainHotQueries(true)) {
+            std::printf("%-28s est %8lld  rows %8d  %8.2f ms%s%s%s%s\n", report.name.c_str(),
+                        static_cast<long long>(report.estimatedRows), report.actualRows, report.ms,
+                        report.fullScan ? "  scan" : "", report.tempBTree ? "  temp-b-tree" : "",
+                        report.autoIndex ? "  auto-index" : "", report.regressed ? "  REGRESSED" : "");
+        }
+    }
+    std::cout << (ok ? "All hot queries use indexes" : "Query plan check failed") << std::endl;
+    return ok ? 0 : 1;
+}
+
+static int runReconcile(int argc, char** argv) {
+    std::string dbPath = "data/library.db";
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--db") == 0 && i + 1 < argc) dbPath = argv[++i];
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    DatabaseManager db(dbPath);
+    CounterDrift drift;
+    if (!db.reconcileCounters(drift)) {
+        std::cout << "Reconciliation failed" << std::endl;
+        return 1;
+    }
+    if (drift.empty()) {
+        std::cout << "All counters match the loans table" << std::endl;
+        return 0;
+    }
+    std::cout << "Fixed " << drift.books << " book(s) and " << drift.members << " member(s):" << std::endl;
+    for (const auto& detail : drift.details) {
+        std::cout << "  " << detail << std::endl;
+    }
+    return 0;
+}
+
+// Loads the loans table sequentially and then on 1, 2, 4 ... N threads, keeping the fastest of
+// `runs` attempts of each so the OS file cache is warm for all of them.
+static int runBenchLoad(int argc, char** argv) {
+    std::string dbPath = "data/library.db";
+    int maxThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    int runs = 3;
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--db") == 0 && i + 1 < argc) dbPath = argv[++i];
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) maxThreads = std::max(1, std::stoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--runs") == 0 && i + 1 < argc) runs = std::max(1, std::stoi(argv[++i]));
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    DatabaseManager db(dbPath);
+    auto best = [runs](const std::function<std::size_t()>& load, std::size_t& rows) {
+        double fastest = 0.0;
+        for (int run = 0; run < runs; ++run) {
+            auto start = std::chrono::steady_clock::now();
+            rows = load();
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (run == 0 || seconds < fastest) fastest = seconds;
+        }
+        return fastest;
+    };
+
+    std::size_t expected = 0;
+    double sequential = best([&] { return db.getAllLoans().size(); }, expected);
+    std::printf("%-12s %10zu rows %9.3f s %12.0f rows/s\n", "sequential", expected, sequential,
+                sequential > 0.0 ? expected / sequential : 0.0);
+
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < maxThreads; threads *= 2) threadCounts.push_back(threads);
+    threadCounts.push_back(maxThreads);
+
+    bool ok = true;
+    double single = 0.0;
+    for (int threads : threadCounts) {
+        std::size_t rows = 0;
+        double seconds = best([&] { return db.getAllLoansParallel(threads).size(); }, rows);
+        if (threads == 1) single = seconds;
+        std::printf("%2d thread(s) %10zu rows %9.3f s %12.0f rows/s  x%.2f\n", threads, rows, seconds,
+                    seconds > 0.0 ? rows / seconds : 0.0, seconds > 0.0 ? single / seconds : 0.0);
+        if (rows != expected) {
+            std::cout << "  row count differs from the sequential load" << std::endl;
+            ok = false;
+        }
+    }
+    return ok ? 0 : 1;
+}
+
+// Adds `count` members through a worker, as a rush of desk edits would, with each write committed on
+// its own and then with group commit. Runs against a scratch database created in the temp directory;
+// only that file is deleted afterwards, never an existing database.
+static int runBenchWrites(int argc, char** argv) {
+    int count = 2000;
+    int windowMs = 2;
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--count") == 0 && i + 1 < argc) count = std::max(1, std::stoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--window") == 0 && i + 1 < argc) windowMs = std::max(0, std::stoi(argv[++i]));
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::path directory = std::filesystem::temp_directory_path(error);
+    if (error) {
+        std::cerr << "No temp directory for the scratch database: " << error.message() << std::endl;
+        return 1;
+    }
+    auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    std::string dbPath;
+    for (int attempt = 0; dbPath.empty() || std::filesystem::exists(dbPath, error); ++attempt) {
+        dbPath = (directory / ("library-bench-writes-" + std::to_string(stamp) + "-" + std::to_string(attempt) + ".db")).string();
+    }
+    std::cout << "Scratch database: " << dbPath << std::endl;
+
+    bool ok = true;
+    {
+        DatabaseManager db(dbPath);
+        int membersBefore = db.countMembers();
+        auto bench = [&](const char* label, const GroupCommit& grouping) {
+            DatabaseWorker worker(db, grouping);
+            int finished = 0;
+            int failed = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < count; ++i) {
+                std::string name = std::string(label) + " " + std::to_string(i);
+                Member member(0, name, name + "@bench.local", "", Member::Type::STUDENT);
+                worker.submitWrite([member](DatabaseManager& db) { return db.addMember(member); },
+                                   [&](bool written) { ++finished; if (!written) ++failed; });
+            }
+            while (finished < count) {
+                worker.poll();
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::printf("%-16s %8d writes %9.3f s %10.0f writes/s\n", label, count, seconds,
+                        seconds > 0.0 ? count / seconds : 0.0);
+            if (failed > 0) {
+                std::cout << "  " << failed << " write(s) failed" << std::endl;
+                ok = false;
+            }
+        };
+
+        GroupCommit single;
+        single.enabled = false;
+        GroupCommit grouped;
+        grouped.window = std::chrono::milliseconds(windowMs);
+        bench("one-per-commit", single);
+        bench("group-commit", grouped);
+        if (db.countMembers() != membersBefore + 2 * count) ok = false;
+    }
+    for (const char* suffix : { "", "-wal", "-shm", "-journal" }) {
+        std::remove((dbPath + suffix).c_str());
+    }
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
     try {
-        Application app;
+        StorageOptions storage;
+        if (argc == 2 && std::strcmp(argv[1], "--wal") == 0) {
+            storage = StorageOptions::wal();
+        } else if (argc > 1) {
+            if (std::strcmp(argv[1], "--import") == 0) return runImport(argc, argv);
+            if (std::strcmp(argv[1], "--check-plans") == 0) return runCheckPlans(argc, argv);
+            if (std::strcmp(argv[1], "--reconcile") == 0) return runReconcile(argc, argv);
+            if (std::strcmp(argv[1], "--bench-load") == 0) return runBenchLoad(argc, argv);
+            if (std::strcmp(argv[1], "--bench-writes") == 0) return runBenchWrites(argc, argv);
+            printUsage();
+            return 1;
+        }
+
+        Application app(storage);
         if (app.initialize()) {
             app.run();
         }
@@ -11,6 +279,6 @@ int main() {
         std::cerr << "Помилка: " << e.what() << std::endl;
         return -1;
     }
-    
+
     return 0;
 }